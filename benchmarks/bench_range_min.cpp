@@ -0,0 +1,90 @@
+// Range-minimum throughput: segments_tree (single and batched queries) vs
+// wide_segments_tree vs mapped_segments_tree vs sparse_table_rmq on a
+// multi-million element array.  The mapped tree is written to mapped_file.
+//
+//   bench_range_min [array_size] [queries] [batch_threads] [mapped_file]
+
+#include "commonlibs/segment_tree.hpp"
+#include "commonlibs/wide_segment_tree.hpp"
+#include "commonlibs/mapped_segment_tree.hpp"
+#include "commonlibs/sparse_table.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <utility>
+#include <vector>
+
+template <class Tree>
+static void run(const char *name, Tree &tree, const std::vector<int> &qi, const std::vector<int> &qj)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    tree.initialize();
+    auto t1 = std::chrono::steady_clock::now();
+    long long checksum = 0;
+    for (std::size_t k = 0; k < qi.size(); ++k)
+        checksum += tree.query(0, qi[k], qj[k]);
+    auto t2 = std::chrono::steady_clock::now();
+
+    double build_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    double query_ns = std::chrono::duration<double, std::nano>(t2 - t1).count() / qi.size();
+    std::printf("%-24s build %9.2f ms   query %8.1f ns   checksum %lld\n", name, build_ms, query_ns, checksum);
+}
+
+int main(int argc, char **argv)
+{
+    const int n = argc > 1 ? std::atoi(argv[1]) : 1 << 23;
+    const int nq = argc > 2 ? std::atoi(argv[2]) : 2000000;
+
+    std::mt19937 gen(42);
+    std::vector<int> a(n);
+    for (int &x : a) x = (int)(gen() >> 1);
+    std::vector<int> qi(nq), qj(nq);
+    std::uniform_int_distribution<int> pos(0, n - 1);
+    for (int k = 0; k < nq; ++k) {
+        int i = pos(gen), j = pos(gen);
+        qi[k] = i < j ? i : j;
+        qj[k] = i < j ? j : i;
+    }
+    std::printf("array size %d, %d random queries\n", n, nq);
+
+    commonlibs::segments_tree seg(a.data(), n);
+    run("segments_tree", seg, qi, qj);
+
+    const unsigned threads = argc > 3 ? (unsigned)std::atoi(argv[3]) : 1;
+    std::vector<std::pair<int, int> > q(nq);
+    for (int k = 0; k < nq; ++k) q[k] = std::make_pair(qi[k], qj[k]);
+    std::vector<int> out(nq);
+    auto b0 = std::chrono::steady_clock::now();
+    seg.query_batch(q.data(), q.size(), out.data(), threads);
+    auto b1 = std::chrono::steady_clock::now();
+    long long checksum = 0;
+    for (int x : out) checksum += x;
+    std::printf("%-24s                    query %8.1f ns   checksum %lld  (%u threads)\n", "segments_tree batch",
+                std::chrono::duration<double, std::nano>(b1 - b0).count() / nq, checksum, threads);
+
+    commonlibs::wide_segments_tree<8> wide8(a.data(), n);
+    run("wide_segments_tree<8>", wide8, qi, qj);
+    commonlibs::wide_segments_tree<16> wide16(a.data(), n);
+    run("wide_segments_tree<16>", wide16, qi, qj);
+
+    const char *path = argc > 4 ? argv[4] : "/tmp/bench_range_min.mst";
+    auto m0 = std::chrono::steady_clock::now();
+    commonlibs::mapped_segments_tree<8>::build(path, a.data(), n);
+    auto m1 = std::chrono::steady_clock::now();
+    commonlibs::mapped_segments_tree<8> mapped;
+    if (mapped.open(path) == 0) {
+        auto m2 = std::chrono::steady_clock::now();
+        checksum = 0;
+        for (int k = 0; k < nq; ++k)
+            checksum += mapped.query(qi[k], qj[k]);
+        auto m3 = std::chrono::steady_clock::now();
+        std::printf("%-24s build %9.2f ms   query %8.1f ns   checksum %lld  (open %.3f ms)\n", "mapped_segments_tree<8>",
+                    std::chrono::duration<double, std::milli>(m1 - m0).count(),
+                    std::chrono::duration<double, std::nano>(m3 - m2).count() / nq, checksum,
+                    std::chrono::duration<double, std::milli>(m2 - m1).count());
+    }
+    commonlibs::sparse_table_rmq st(a.data(), n);
+    run("sparse_table_rmq", st, qi, qj);
+    return 0;
+}
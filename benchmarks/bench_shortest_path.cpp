@@ -0,0 +1,171 @@
+// Dijkstra time per queue policy: binary_heap_queue (the std::priority_queue
+// with lazy deletion) vs radix_heap_queue vs dial_queue vs
+// indexed_heap_queue<4>, all on the same csr_graph.
+//
+// grid: a side x side 4-neighbour grid with weights 1..9, where Dial's
+// buckets are dense.  road: a jittered grid in metres with some streets
+// missing, a few diagonals, and every 32nd row and column an arterial at a
+// third of the cost, so weights run into the hundreds.  Each policy runs
+// the same full searches and point-to-point queries; the checksums must
+// agree.  The last rows answer the point-to-point queries with
+// Dijkstra_bidirectional and with Astar on the straight-line distance, and
+// give the vertices each one scans.
+//
+//   bench_shortest_path [side] [searches]
+
+#include "commonlibs/algorithms.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using commonlibs::graph_edge;
+
+// vertex coordinates, for the A* heuristic
+struct coordinates {
+    std::vector<double> x, y;
+};
+
+static std::vector<graph_edge> grid_edges(int side, std::mt19937 &gen, coordinates &xy)
+{
+    xy.x.resize(side * side);
+    xy.y.resize(side * side);
+    for (int v = 0; v < side * side; ++v) {
+        xy.x[v] = v % side;
+        xy.y[v] = v / side;
+    }
+    std::vector<graph_edge> edges;
+    for (int r = 0; r < side; ++r)
+        for (int c = 0; c < side; ++c) {
+            const int v = r * side + c;
+            if (c + 1 < side) {
+                edges.push_back({v, v + 1, 1 + (int)(gen() % 9)});
+                edges.push_back({v + 1, v, 1 + (int)(gen() % 9)});
+            }
+            if (r + 1 < side) {
+                edges.push_back({v, v + side, 1 + (int)(gen() % 9)});
+                edges.push_back({v + side, v, 1 + (int)(gen() % 9)});
+            }
+        }
+    return edges;
+}
+
+static std::vector<graph_edge> road_edges(int side, std::mt19937 &gen, coordinates &xy)
+{
+    std::uniform_real_distribution<double> jitter(-30.0, 30.0);
+    std::vector<double> &x = xy.x, &y = xy.y;
+    x.resize(side * side);
+    y.resize(side * side);
+    for (int r = 0; r < side; ++r)
+        for (int c = 0; c < side; ++c) {
+            x[r * side + c] = c * 100.0 + jitter(gen);
+            y[r * side + c] = r * 100.0 + jitter(gen);
+        }
+    std::vector<graph_edge> edges;
+    auto road = [&](int u, int v, bool arterial) {
+        int w = (int)std::lround(std::hypot(x[u] - x[v], y[u] - y[v]));
+        if (arterial) w /= 3;
+        edges.push_back({u, v, w});
+        edges.push_back({v, u, w});
+    };
+    for (int r = 0; r < side; ++r)
+        for (int c = 0; c < side; ++c) {
+            const int v = r * side + c;
+            if (c + 1 < side && (r % 32 == 0 || gen() % 10 != 0))
+                road(v, v + 1, r % 32 == 0);
+            if (r + 1 < side && (c % 32 == 0 || gen() % 10 != 0))
+                road(v, v + side, c % 32 == 0);
+            if (c + 1 < side && r + 1 < side && gen() % 10 == 0)
+                road(v, v + side + 1, false);
+        }
+    return edges;
+}
+
+template <class Queue>
+static void run(const char *name, const commonlibs::csr_graph &g, const std::vector<int> &from, const std::vector<int> &to)
+{
+    commonlibs::basic_shortest_path_algo<Queue> algo;
+    long long full = 0, p2p = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int s : from) {
+        algo.Dijkstra(g, s);
+        full += algo.distance(to[0]) + algo.distance(g.vertex_count() - 1);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (std::size_t k = 0; k < from.size(); ++k) {
+        algo.Dijkstra(g, from[k], to[k]);
+        p2p += algo.distance(to[k]);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    std::printf("  %-24s full %8.2f ms   point-to-point %8.2f ms   checksums %lld %lld\n", name,
+                std::chrono::duration<double, std::milli>(t1 - t0).count() / from.size(),
+                std::chrono::duration<double, std::milli>(t2 - t1).count() / from.size(), full, p2p);
+}
+
+template <class Search>
+static void point_to_point(const char *name, Search search, const std::vector<int> &from, const std::vector<int> &to)
+{
+    long long p2p = 0, scanned = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (std::size_t k = 0; k < from.size(); ++k) {
+        scanned += search(from[k], to[k], p2p);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    std::printf("  %-24s point-to-point %8.2f ms   scanned %9lld   checksum %lld\n", name,
+                std::chrono::duration<double, std::milli>(t1 - t0).count() / from.size(), scanned / (long long)from.size(), p2p);
+}
+
+// scale: the lowest cost per unit of straight-line length
+static void bench(const char *label, int n, const std::vector<graph_edge> &edges, const coordinates &xy, double scale,
+                  int searches, std::mt19937 &gen)
+{
+    commonlibs::csr_graph g;
+    if (g.build(n, edges) != 0)
+        std::exit(1);
+    std::vector<int> from(searches), to(searches);
+    for (int k = 0; k < searches; ++k) {
+        from[k] = (int)(gen() % n);
+        to[k] = (int)(gen() % n);
+    }
+    std::printf("%s: %d vertices, %zu edges, %d searches\n", label, n, g.edge_count(), searches);
+    run<commonlibs::binary_heap_queue>("binary_heap_queue", g, from, to);
+    run<commonlibs::radix_heap_queue>("radix_heap_queue", g, from, to);
+    run<commonlibs::dial_queue>("dial_queue", g, from, to);
+    run<commonlibs::indexed_heap_queue<4> >("indexed_heap_queue<4>", g, from, to);
+
+    const commonlibs::csr_graph r = g.reversed();
+    const commonlibs::euclidean_heuristic h(xy.x, xy.y, scale);
+    commonlibs::basic_shortest_path_algo<commonlibs::dial_queue> algo;
+    point_to_point("dial Dijkstra", [&](int s, int t, long long &sum) {
+        algo.Dijkstra(g, s, t);
+        sum += algo.distance(t);
+        return algo.scanned();
+    }, from, to);
+    point_to_point("dial bidirectional", [&](int s, int t, long long &sum) {
+        algo.Dijkstra_bidirectional(g, r, s, t);
+        sum += algo.distance(t);
+        return algo.scanned();
+    }, from, to);
+    point_to_point("dial A*", [&](int s, int t, long long &sum) {
+        algo.Astar(g, s, t, h);
+        sum += algo.distance(t);
+        return algo.scanned();
+    }, from, to);
+}
+
+int main(int argc, char **argv)
+{
+    const int side = argc > 1 ? std::atoi(argv[1]) : 1000;
+    const int searches = argc > 2 ? std::atoi(argv[2]) : 20;
+
+    std::mt19937 gen(42);
+    coordinates xy;
+    std::vector<graph_edge> edges = grid_edges(side, gen, xy);
+    bench("grid", side * side, edges, xy, 1.0, searches, gen);
+    // arterials cost a third of the length, less rounding
+    edges = road_edges(side, gen, xy);
+    bench("road", side * side, edges, xy, 0.3, searches, gen);
+    return 0;
+}
@@ -0,0 +1,196 @@
+// Trie memory and lookup latency: Vertex vs arena_trie vs double_array_trie
+// vs louds_trie vs adaptive_radix_tree on URL-like and identifier-like keys.
+// The letter tries get the same keys with every byte folded onto 'a'..'z'.
+// The countWords_batch row is the speed-up of prefetched lock-step lookups
+// over the countWords loop above it; it shows once the Vertex trie outgrows
+// the last-level cache (raise keys if it does not).  The fuzzy_search rows
+// time edit-distance queries on the same Vertex trie.
+//
+//   bench_trie [keys] [lookups]
+
+#include "commonlibs/prefix_tree.hpp"
+#include "commonlibs/arena_trie.hpp"
+#include "commonlibs/double_array_trie.hpp"
+#include "commonlibs/adaptive_radix_tree.hpp"
+#include "commonlibs/louds_trie.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+static std::vector<std::string> url_keys(int n, std::mt19937 &gen)
+{
+    const char *hosts[] = {"https://www.example.com/", "https://api.example.com/v2/", "http://cdn.static-files.net/img/",
+                           "https://docs.example.org/guide/", "https://shop.example.com/item/"};
+    const char *words[] = {"users", "orders", "profile", "settings", "search", "index", "assets", "reports", "2024", "page"};
+    std::vector<std::string> keys(n);
+    for (std::string &k : keys) {
+        k = hosts[gen() % 5];
+        int parts = 1 + gen() % 3;
+        for (int p = 0; p < parts; ++p) {
+            k += words[gen() % 10];
+            k += '/';
+        }
+        k += std::to_string(gen() % 1000000);
+    }
+    return keys;
+}
+
+static std::vector<std::string> identifier_keys(int n, std::mt19937 &gen)
+{
+    const char *verbs[] = {"get", "set", "update", "make", "parse", "load", "find", "is"};
+    const char *nouns[] = {"user", "order", "item", "config", "buffer", "node", "edge", "path", "name", "id"};
+    std::vector<std::string> keys(n);
+    for (std::string &k : keys) {
+        k = verbs[gen() % 8];
+        int parts = 1 + gen() % 3;
+        for (int p = 0; p < parts; ++p) {
+            k += '_';
+            k += nouns[gen() % 10];
+        }
+        k += std::to_string(gen() % 10000);
+    }
+    return keys;
+}
+
+static std::string letters(const std::string &s)
+{
+    std::string out(s);
+    for (char &c : out) c = (char)('a' + (unsigned char)c % 26);
+    return out;
+}
+
+static std::size_t vertex_nodes(const commonlibs::Vertex *v)
+{
+    std::size_t n = 1;
+    for (int k = 0; k < commonlibs::Vertex::num_leaves; ++k)
+        if (v->edges[k] != NULL) n += vertex_nodes(v->edges[k]);
+    return n;
+}
+
+template <class Trie>
+static double lookups(const char *name, const Trie &t, const std::vector<std::string> &probe, double build_ms, std::size_t bytes)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    long long hits = 0;
+    for (const std::string &k : probe)
+        hits += t.countWords(k.data(), k.size());
+    auto t1 = std::chrono::steady_clock::now();
+    std::printf("  %-24s build %8.1f ms   memory %8.1f MB   lookup %7.1f ns   hits %lld\n", name, build_ms,
+                bytes / 1048576.0, std::chrono::duration<double, std::nano>(t1 - t0).count() / probe.size(), hits);
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / probe.size();
+}
+
+// countWords_batch over the same probes; memory is the trie's, shown again
+static void batch_lookups(const char *name, const commonlibs::Vertex &v, const std::vector<std::string> &probe,
+                          double single_ns, std::size_t bytes)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<int> counts = v.countWords_batch(probe);
+    auto t1 = std::chrono::steady_clock::now();
+    long long hits = 0;
+    for (int c : counts) hits += c;
+    const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / probe.size();
+    std::printf("  %-24s                  memory %8.1f MB   lookup %7.1f ns   hits %lld   (%.2fx)\n", name,
+                bytes / 1048576.0, ns, hits, single_ns / ns);
+}
+
+// "did you mean": probes with one letter changed, searched within d edits
+static void fuzzy_lookups(commonlibs::Vertex *v, const std::vector<std::string> &probe, std::mt19937 &gen)
+{
+    std::vector<std::string> typo(probe.begin(), probe.begin() + std::min<std::size_t>(probe.size(), 1000));
+    for (std::string &t : typo) t[gen() % t.size()] = (char)('a' + gen() % 26);
+    for (int d = 1; d <= 2; ++d) {
+        auto t0 = std::chrono::steady_clock::now();
+        long long found = 0;
+        for (const std::string &t : typo)
+            for (commonlibs::fuzzy_iterator it(v, t.data(), t.size(), d), end; it != end; ++it) ++found;
+        auto t1 = std::chrono::steady_clock::now();
+        std::printf("  %-24s %9.1f us per query   matches %lld\n", d == 1 ? "fuzzy_search d=1" : "fuzzy_search d=2",
+                    std::chrono::duration<double, std::micro>(t1 - t0).count() / typo.size(), found);
+    }
+}
+
+static void run(const char *label, const std::vector<std::string> &keys, int nprobe, std::mt19937 &gen)
+{
+    std::vector<std::string> folded(keys.size());
+    for (std::size_t k = 0; k < keys.size(); ++k) folded[k] = letters(keys[k]);
+    std::vector<std::size_t> pick(nprobe);
+    for (std::size_t &p : pick) p = gen() % keys.size();
+    std::vector<std::string> probe(nprobe), probe_folded(nprobe);
+    for (int k = 0; k < nprobe; ++k) {
+        probe[k] = keys[pick[k]];
+        probe_folded[k] = folded[pick[k]];
+    }
+    std::printf("%s: %zu keys\n", label, keys.size());
+
+    auto t0 = std::chrono::steady_clock::now();
+    commonlibs::Vertex *v = new commonlibs::Vertex();
+    for (const std::string &k : folded) v->addWord(k.data(), k.size());
+    auto t1 = std::chrono::steady_clock::now();
+    struct vertex_view {
+        commonlibs::Vertex *v;
+        int countWords(const char *p, size_t n) const { return v->countWords(p, n); }
+    } view = {v};
+    const std::size_t vertex_bytes = vertex_nodes(v) * sizeof(commonlibs::Vertex);
+    const double single_ns = lookups("Vertex", view, probe_folded, std::chrono::duration<double, std::milli>(t1 - t0).count(),
+                                     vertex_bytes);
+    batch_lookups("Vertex countWords_batch", *v, probe_folded, single_ns, vertex_bytes);
+    fuzzy_lookups(v, probe_folded, gen);
+
+    t0 = std::chrono::steady_clock::now();
+    commonlibs::double_array_trie da = commonlibs::double_array_trie::freeze(*v);
+    t1 = std::chrono::steady_clock::now();
+    lookups("double_array_trie", da, probe_folded, std::chrono::duration<double, std::milli>(t1 - t0).count(), da.bytes());
+
+    t0 = std::chrono::steady_clock::now();
+    commonlibs::louds_trie louds = commonlibs::louds_trie::freeze(*v);
+    t1 = std::chrono::steady_clock::now();
+    lookups("louds_trie", louds, probe_folded, std::chrono::duration<double, std::milli>(t1 - t0).count(), louds.bytes());
+
+    // a saved trie file: "build" is the time to map it at startup
+    const char *path = "/tmp/bench_trie.dat";
+    da.save(path);
+    t0 = std::chrono::steady_clock::now();
+    commonlibs::mapped_double_array_trie mapped;
+    mapped.open(path);
+    t1 = std::chrono::steady_clock::now();
+    lookups("mapped_double_array", mapped, probe_folded, std::chrono::duration<double, std::milli>(t1 - t0).count(), da.bytes());
+    delete v;
+
+    std::vector<std::string> sorted(folded);
+    std::sort(sorted.begin(), sorted.end());
+    t0 = std::chrono::steady_clock::now();
+    v = new commonlibs::Vertex();
+    v->build_from_sorted(sorted.begin(), sorted.end());
+    t1 = std::chrono::steady_clock::now();
+    view.v = v;
+    lookups("Vertex build_from_sorted", view, probe_folded, std::chrono::duration<double, std::milli>(t1 - t0).count(),
+            vertex_nodes(v) * sizeof(commonlibs::Vertex));
+    delete v;
+
+    t0 = std::chrono::steady_clock::now();
+    commonlibs::arena_trie at;
+    for (const std::string &k : folded) at.addWord(k.data(), k.size());
+    t1 = std::chrono::steady_clock::now();
+    lookups("arena_trie", at, probe_folded, std::chrono::duration<double, std::milli>(t1 - t0).count(), at.bytes_reserved());
+
+    t0 = std::chrono::steady_clock::now();
+    commonlibs::adaptive_radix_tree art;
+    for (const std::string &k : keys) art.addWord(k.data(), k.size());
+    t1 = std::chrono::steady_clock::now();
+    lookups("adaptive_radix_tree", art, probe, std::chrono::duration<double, std::milli>(t1 - t0).count(), art.memory_usage());
+}
+
+int main(int argc, char **argv)
+{
+    const int n = argc > 1 ? std::atoi(argv[1]) : 200000;
+    const int nq = argc > 2 ? std::atoi(argv[2]) : 1000000;
+    std::mt19937 gen(7);
+    run("URL-like", url_keys(n, gen), nq, gen);
+    run("identifier-like", identifier_keys(n, gen), nq, gen);
+    return 0;
+}
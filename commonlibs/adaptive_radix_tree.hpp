@@ -0,0 +1,520 @@
+#ifndef __COMMONLIBS_ADAPTIVE_RADIX_TREE_HPP
+
+#define __COMMONLIBS_ADAPTIVE_RADIX_TREE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace commonlibs {
+// Adaptive radix tree (Leis et al., ICDE 2013) over arbitrary byte strings,
+// counting how often each key was added, with the counting interface of
+// Vertex.
+//
+// Inner nodes grow through four layouts as children are added: Node4 and
+// Node16 keep sorted key bytes next to the child pointers (Node16 finds a
+// byte with one SSE2 compare of all sixteen), Node48 maps a byte to one of
+// 48 slots, Node256 indexes directly.  A chain of single-child nodes is
+// collapsed into the prefix of the node below it; the first max_prefix
+// bytes are kept inline and longer prefixes are checked against a leaf.
+// Leaves hold the whole key, so a lookup only reads the key bytes it has to
+// and confirms the match once at the end.  A key that is a prefix of
+// another one ends in the "term" leaf of the inner node where it stops.
+//
+// Keys may hold any byte, including '\0'; the empty key is a valid key.
+// There is no erase, so a leaf never leaves the subtree it was put in.
+class adaptive_radix_tree {
+public:
+	adaptive_radix_tree() {
+		root = NULL ;
+		nbytes = 0 ;
+		nkeys = 0 ;
+	}
+
+	~adaptive_radix_tree() {
+		destroy(root) ;
+	}
+
+	adaptive_radix_tree(const adaptive_radix_tree &) = delete ;
+	adaptive_radix_tree & operator=(const adaptive_radix_tree &) = delete ;
+
+	// adds one occurrence of the key p_word[0 .. size).
+	// returns the number of occurrences of that key after the add.
+	int addWord(const char *p_word, size_t size) {
+		if(p_word == NULL)
+			size = 0 ;
+		return insert(&root, (const uint8_t *) p_word, size, 0) ;
+	}
+
+	// number of times the key was added; 0 if absent
+	int countWords(const char *p_word, size_t size) const {
+		if(p_word == NULL)
+			size = 0 ;
+		const uint8_t *key = (const uint8_t *) p_word ;
+		const void *n = root ;
+		size_t depth = 0 ;
+		while(n != NULL) {
+			if(is_leaf(n)) {
+				return leaf_matches(as_leaf(n), key, size) ? as_leaf(n)->words : 0 ;
+			}
+			const node_t *in = (const node_t *) n ;
+			if(in->prefix_len > 0) {
+				// only the inline bytes here; the leaf check settles the rest
+				if(depth + in->prefix_len > size)
+					return 0 ;
+				const size_t stored = in->prefix_len < max_prefix ? in->prefix_len : max_prefix ;
+				if(std::memcmp(in->prefix, key + depth, stored) != 0)
+					return 0 ;
+				depth += in->prefix_len ;
+			}
+			if(depth == size) {
+				return in->term != NULL && leaf_matches(in->term, key, size) ? in->term->words : 0 ;
+			}
+			n = find_child(in, key[depth]) ;
+			++ depth ;
+		}
+		return 0 ;
+	}
+
+	// number of distinct bytes that follow the prefix p_word[0 .. size) in
+	// the stored keys, as Vertex::countPrefixes; 0 if no key starts with it
+	int countPrefixes(const char *p_word, size_t size) const {
+		if(p_word == NULL)
+			size = 0 ;
+		const uint8_t *key = (const uint8_t *) p_word ;
+		const void *n = root ;
+		size_t depth = 0 ;
+		while(n != NULL) {
+			if(is_leaf(n)) {
+				const leaf_t *l = as_leaf(n) ;
+				if(l->len < size || std::memcmp(l->key + depth, key + depth, size - depth) != 0)
+					return 0 ;
+				return l->len > size ? 1 : 0 ;
+			}
+			const node_t *in = (const node_t *) n ;
+			if(in->prefix_len > 0) {
+				const size_t cmp = depth + in->prefix_len <= size ? in->prefix_len : size - depth ;
+				if(! prefix_matches(in, key, depth, cmp))
+					return 0 ;
+				if(depth + in->prefix_len > size)
+					return 1 ; // the prefix ends inside a collapsed path
+				depth += in->prefix_len ;
+			}
+			if(depth == size) {
+				return in->count ;
+			}
+			n = find_child(in, key[depth]) ;
+			++ depth ;
+		}
+		return 0 ;
+	}
+
+	// number of distinct keys
+	std::size_t size() const {
+		return nkeys ;
+	}
+
+	// bytes held by nodes and leaves
+	std::size_t memory_usage() const {
+		return nbytes ;
+	}
+
+	void clear() {
+		destroy(root) ;
+		root = NULL ;
+		nbytes = 0 ;
+		nkeys = 0 ;
+	}
+
+private:
+	static constexpr size_t max_prefix = 8 ;
+	enum { node4 = 0, node16 = 1, node48 = 2, node256 = 3 } ;
+
+	struct leaf_t {
+		uint32_t len ;
+		int words ;
+		uint8_t key[1] ;  // len bytes are allocated
+	} ;
+
+	struct node_t {
+		uint8_t type ;
+		uint16_t count ;       // number of children, term not included
+		uint32_t prefix_len ;
+		uint8_t prefix[max_prefix] ;
+		leaf_t *term ;         // key ending at this node, or NULL
+	} ;
+
+	struct node4_t : node_t {
+		uint8_t keys[4] ;
+		void *child[4] ;
+	} ;
+
+	struct node16_t : node_t {
+		uint8_t keys[16] ;
+		void *child[16] ;
+	} ;
+
+	struct node48_t : node_t {
+		uint8_t index[256] ;  // slot + 1, 0 if absent
+		void *child[48] ;
+	} ;
+
+	struct node256_t : node_t {
+		void *child[256] ;
+	} ;
+
+	// children are tagged pointers, the low bit marks a leaf
+	static bool is_leaf(const void *p) {
+		return ((uintptr_t) p & 1) != 0 ;
+	}
+
+	static leaf_t * as_leaf(const void *p) {
+		return (leaf_t *) ((uintptr_t) p & ~(uintptr_t) 1) ;
+	}
+
+	static void * leaf_ref(leaf_t *l) {
+		return (void *) ((uintptr_t) l | 1) ;
+	}
+
+	static bool leaf_matches(const leaf_t *l, const uint8_t *key, size_t size) {
+		return l->len == size && std::memcmp(l->key, key, size) == 0 ;
+	}
+
+	leaf_t * make_leaf(const uint8_t *key, size_t size) {
+		const size_t bytes = offsetof(leaf_t, key) + (size > 0 ? size : 1) ;
+		leaf_t *l = (leaf_t *) std::malloc(bytes) ;
+		if(l == NULL)
+			throw std::bad_alloc() ;
+		l->len = (uint32_t) size ;
+		l->words = 1 ;
+		if(size > 0)
+			std::memcpy(l->key, key, size) ;
+		nbytes += bytes ;
+		++ nkeys ;
+		return l ;
+	}
+
+	template <class N>
+	N * make_node() {
+		N *n = new N() ; // value-initialised: no children, empty prefix
+		n->type = node_type((N *) NULL) ;
+		nbytes += sizeof(N) ;
+		return n ;
+	}
+
+	static uint8_t node_type(node4_t *) { return node4 ; }
+	static uint8_t node_type(node16_t *) { return node16 ; }
+	static uint8_t node_type(node48_t *) { return node48 ; }
+	static uint8_t node_type(node256_t *) { return node256 ; }
+
+	void free_node(node_t *n) {
+		switch(n->type) {
+		case node4: nbytes -= sizeof(node4_t) ; delete (node4_t *) n ; break ;
+		case node16: nbytes -= sizeof(node16_t) ; delete (node16_t *) n ; break ;
+		case node48: nbytes -= sizeof(node48_t) ; delete (node48_t *) n ; break ;
+		default: nbytes -= sizeof(node256_t) ; delete (node256_t *) n ; break ;
+		}
+	}
+
+	void destroy(void *p) {
+		if(p == NULL)
+			return ;
+		if(is_leaf(p)) {
+			std::free(as_leaf(p)) ;
+			return ;
+		}
+		node_t *n = (node_t *) p ;
+		if(n->term != NULL)
+			std::free(n->term) ;
+		switch(n->type) {
+		case node4:
+			for(int k = 0 ; k < n->count ; ++ k) destroy(((node4_t *) n)->child[k]) ;
+			delete (node4_t *) n ;
+			break ;
+		case node16:
+			for(int k = 0 ; k < n->count ; ++ k) destroy(((node16_t *) n)->child[k]) ;
+			delete (node16_t *) n ;
+			break ;
+		case node48:
+			for(int k = 0 ; k < n->count ; ++ k) destroy(((node48_t *) n)->child[k]) ;
+			delete (node48_t *) n ;
+			break ;
+		default:
+			for(int k = 0 ; k < 256 ; ++ k) destroy(((node256_t *) n)->child[k]) ;
+			delete (node256_t *) n ;
+			break ;
+		}
+	}
+
+	// slot of the child for byte c, or NULL
+	static void ** find_slot(node_t *n, uint8_t c) {
+		switch(n->type) {
+		case node4: {
+			node4_t *p = (node4_t *) n ;
+			for(int k = 0 ; k < p->count ; ++ k)
+				if(p->keys[k] == c)
+					return &p->child[k] ;
+			return NULL ;
+		}
+		case node16: {
+			node16_t *p = (node16_t *) n ;
+#if defined(__SSE2__)
+			const __m128i hit = _mm_cmpeq_epi8(_mm_set1_epi8((char) c), _mm_loadu_si128((const __m128i *) p->keys)) ;
+			const unsigned int mask = (unsigned int) _mm_movemask_epi8(hit) & ((1u << p->count) - 1) ;
+			return mask != 0 ? &p->child[__builtin_ctz(mask)] : NULL ;
+#else
+			for(int k = 0 ; k < p->count ; ++ k)
+				if(p->keys[k] == c)
+					return &p->child[k] ;
+			return NULL ;
+#endif
+		}
+		case node48: {
+			node48_t *p = (node48_t *) n ;
+			return p->index[c] != 0 ? &p->child[p->index[c] - 1] : NULL ;
+		}
+		default: {
+			node256_t *p = (node256_t *) n ;
+			return p->child[c] != NULL ? &p->child[c] : NULL ;
+		}
+		}
+	}
+
+	static const void * find_child(const node_t *n, uint8_t c) {
+		void **slot = find_slot(const_cast<node_t *>(n), c) ;
+		return slot != NULL ? *slot : NULL ;
+	}
+
+	// leaf with the smallest key below p; any leaf of the subtree carries
+	// the node prefixes on its path
+	static const leaf_t * minimum(const void *p) {
+		while(! is_leaf(p)) {
+			const node_t *n = (const node_t *) p ;
+			if(n->term != NULL)
+				return n->term ;
+			switch(n->type) {
+			case node4: p = ((const node4_t *) n)->child[0] ; break ;
+			case node16: p = ((const node16_t *) n)->child[0] ; break ;
+			case node48: {
+				const node48_t *q = (const node48_t *) n ;
+				int c = 0 ;
+				while(q->index[c] == 0) ++ c ;
+				p = q->child[q->index[c] - 1] ;
+				break ;
+			}
+			default: {
+				const node256_t *q = (const node256_t *) n ;
+				int c = 0 ;
+				while(q->child[c] == NULL) ++ c ;
+				p = q->child[c] ;
+				break ;
+			}
+			}
+		}
+		return as_leaf(p) ;
+	}
+
+	// compares the first cmp bytes of the node prefix with key[depth ..]
+	static bool prefix_matches(const node_t *n, const uint8_t *key, size_t depth, size_t cmp) {
+		const size_t stored = cmp < max_prefix ? cmp : max_prefix ;
+		if(std::memcmp(n->prefix, key + depth, stored) != 0)
+			return false ;
+		if(cmp > max_prefix) {
+			const leaf_t *l = minimum(n) ;
+			return std::memcmp(l->key + depth + max_prefix, key + depth + max_prefix, cmp - max_prefix) == 0 ;
+		}
+		return true ;
+	}
+
+	// first position where the node prefix and key[depth ..] differ; the end
+	// of the key counts as a difference
+	static size_t prefix_mismatch(const node_t *n, const uint8_t *key, size_t size, size_t depth) {
+		const size_t plen = n->prefix_len ;
+		const size_t stored = plen < max_prefix ? plen : max_prefix ;
+		size_t k = 0 ;
+		for( ; k < stored ; ++ k) {
+			if(depth + k >= size || n->prefix[k] != key[depth + k])
+				return k ;
+		}
+		if(plen > max_prefix) {
+			const leaf_t *l = minimum(n) ;
+			for( ; k < plen ; ++ k) {
+				if(depth + k >= size || l->key[depth + k] != key[depth + k])
+					return k ;
+			}
+		}
+		return k ;
+	}
+
+	// adds child under byte c; grows the node, and rewrites *ref, when full
+	void add_child(void **ref, node_t *n, uint8_t c, void *child) {
+		switch(n->type) {
+		case node4: {
+			node4_t *p = (node4_t *) n ;
+			if(p->count < 4) {
+				insert_sorted(p->keys, p->child, p->count, c, child) ;
+				return ;
+			}
+			node16_t *g = make_node<node16_t>() ;
+			copy_header(g, p) ;
+			std::memcpy(g->keys, p->keys, 4) ;
+			std::memcpy(g->child, p->child, 4 * sizeof(void *)) ;
+			free_node(p) ;
+			*ref = g ;
+			insert_sorted(g->keys, g->child, g->count, c, child) ;
+			return ;
+		}
+		case node16: {
+			node16_t *p = (node16_t *) n ;
+			if(p->count < 16) {
+				insert_sorted(p->keys, p->child, p->count, c, child) ;
+				return ;
+			}
+			node48_t *g = make_node<node48_t>() ;
+			copy_header(g, p) ;
+			for(int k = 0 ; k < 16 ; ++ k) {
+				g->child[k] = p->child[k] ;
+				g->index[p->keys[k]] = (uint8_t) (k + 1) ;
+			}
+			free_node(p) ;
+			*ref = g ;
+			add_child(ref, g, c, child) ;
+			return ;
+		}
+		case node48: {
+			node48_t *p = (node48_t *) n ;
+			if(p->count < 48) {
+				p->child[p->count] = child ;
+				p->index[c] = (uint8_t) (p->count + 1) ;
+				++ p->count ;
+				return ;
+			}
+			node256_t *g = make_node<node256_t>() ;
+			copy_header(g, p) ;
+			for(int b = 0 ; b < 256 ; ++ b)
+				if(p->index[b] != 0)
+					g->child[b] = p->child[p->index[b] - 1] ;
+			free_node(p) ;
+			*ref = g ;
+			add_child(ref, g, c, child) ;
+			return ;
+		}
+		default: {
+			node256_t *p = (node256_t *) n ;
+			p->child[c] = child ;
+			++ p->count ;
+			return ;
+		}
+		}
+	}
+
+	template <int N>
+	static void insert_sorted(uint8_t (&keys)[N], void *(&child)[N], uint16_t &count, uint8_t c, void *ch) {
+		int k = count ;
+		while(k > 0 && keys[k - 1] > c) {
+			keys[k] = keys[k - 1] ;
+			child[k] = child[k - 1] ;
+			-- k ;
+		}
+		keys[k] = c ;
+		child[k] = ch ;
+		++ count ;
+	}
+
+	static void copy_header(node_t *dst, const node_t *src) {
+		dst->count = src->count ;
+		dst->prefix_len = src->prefix_len ;
+		std::memcpy(dst->prefix, src->prefix, max_prefix) ;
+		dst->term = src->term ;
+	}
+
+	int insert(void **ref, const uint8_t *key, size_t size, size_t depth) {
+		for(;;) {
+			void *p = *ref ;
+			if(p == NULL) {
+				*ref = leaf_ref(make_leaf(key, size)) ;
+				return 1 ;
+			}
+			if(is_leaf(p)) {
+				leaf_t *l = as_leaf(p) ;
+				if(leaf_matches(l, key, size)) {
+					return ++ l->words ;
+				}
+				// both keys below a new Node4 holding their common part
+				size_t i = depth ;
+				while(i < l->len && i < size && l->key[i] == key[i])
+					++ i ;
+				node4_t *n = make_node<node4_t>() ;
+				n->prefix_len = (uint32_t) (i - depth) ;
+				std::memcpy(n->prefix, key + depth, n->prefix_len < max_prefix ? n->prefix_len : max_prefix) ;
+				leaf_t *nl = make_leaf(key, size) ;
+				place(n, l, i) ;
+				place(n, nl, i) ;
+				*ref = n ;
+				return 1 ;
+			}
+			node_t *n = (node_t *) p ;
+			if(n->prefix_len > 0) {
+				const size_t m = prefix_mismatch(n, key, size, depth) ;
+				if(m < n->prefix_len) {
+					split(ref, n, key, size, depth, m) ;
+					return 1 ;
+				}
+				depth += n->prefix_len ;
+			}
+			if(depth == size) {
+				if(n->term != NULL)
+					return ++ n->term->words ;
+				n->term = make_leaf(key, size) ;
+				return 1 ;
+			}
+			void **slot = find_slot(n, key[depth]) ;
+			if(slot == NULL) {
+				add_child(ref, n, key[depth], leaf_ref(make_leaf(key, size))) ;
+				return 1 ;
+			}
+			ref = slot ;
+			++ depth ;
+		}
+	}
+
+	// puts leaf l under n, whose prefix ends at key position pos
+	void place(node4_t *n, leaf_t *l, size_t pos) {
+		if(l->len == pos)
+			n->term = l ;
+		else
+			insert_sorted(n->keys, n->child, n->count, l->key[pos], leaf_ref(l)) ;
+	}
+
+	// the key leaves the prefix of n after m bytes: a new Node4 takes the
+	// common m bytes, with n (prefix cut) and a leaf for the key below it
+	void split(void **ref, node_t *n, const uint8_t *key, size_t size, size_t depth, size_t m) {
+		node4_t *s = make_node<node4_t>() ;
+		s->prefix_len = (uint32_t) m ;
+		std::memcpy(s->prefix, key + depth, m < max_prefix ? m : max_prefix) ;
+		// the bytes of n beyond the inline part come from any of its leaves
+		const uint8_t *full = n->prefix_len > max_prefix ? minimum(n)->key + depth : n->prefix ;
+		const uint8_t branch = full[m] ;
+		const size_t rest = n->prefix_len - m - 1 ;
+		uint8_t moved[max_prefix] ;
+		std::memcpy(moved, full + m + 1, rest < max_prefix ? rest : max_prefix) ;
+		std::memcpy(n->prefix, moved, rest < max_prefix ? rest : max_prefix) ;
+		n->prefix_len = (uint32_t) rest ;
+		insert_sorted(s->keys, s->child, s->count, branch, (void *) n) ;
+		place(s, make_leaf(key, size), depth + m) ;
+		*ref = s ;
+	}
+
+	void *root ;
+	std::size_t nbytes ;
+	std::size_t nkeys ;
+} ;
+}
+
+#endif
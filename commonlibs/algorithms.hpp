@@ -6,8 +6,11 @@
 #include <vector> 
 #include <iostream> 
 #include <queue>
+#include <cmath>
+#include <cassert>
 
 #include <algorithm> 
+#include <cstddef>
 
 
 namespace commonlibs {
@@ -21,32 +24,665 @@ namespace commonlibs {
 	//typedef std::pair<vertexid_t, vertexid_t>  gedge ;
 	typedef std::vector< std::vector< gedge > > G_vvii ;
 
+	// one directed edge of an edge list
+	struct graph_edge {
+		vertexid_t from ;
+		vertexid_t to ;
+		distance_t weight ;
+	} ;
+
+	// Graph in compressed sparse row form: the out-edges of vertex v are
+	// [offsets[v], offsets[v + 1]) in targets and weights.  Three flat
+	// arrays instead of a heap block per vertex, so a scan of a vertex's
+	// edges is a sequential read, and the targets can be scanned without
+	// pulling in the weights.
+	class csr_graph {
+	public:
+		csr_graph() : offsets(1, 0) {}
+
+		// builds from an edge list over vertices [0, nvertex).  The edges of
+		// each vertex keep their order in the list.
+		// returns 0 on success, -1 if an edge has a vertex out of range.
+		int build(int nvertex, const std::vector<graph_edge> &edges) {
+			if(nvertex < 0) {
+				std::cerr << "Error, csr_graph vertex count " << nvertex << " is negative" << std::endl ;
+				return -1 ;
+			}
+			for(std::size_t k = 0 ; k < edges.size() ; ++ k) {
+				if(edges[k].from < 0 || edges[k].from >= nvertex || edges[k].to < 0 || edges[k].to >= nvertex) {
+					std::cerr << "Error, csr_graph edge " << edges[k].from << " -> " << edges[k].to
+						<< " is out of range [0, " << nvertex << ")" << std::endl ;
+					return -1 ;
+				}
+			}
+			// counting sort by source, stable
+			offsets.assign(nvertex + 1, 0) ;
+			for(std::size_t k = 0 ; k < edges.size() ; ++ k)
+				++ offsets[edges[k].from + 1] ;
+			for(int v = 0 ; v < nvertex ; ++ v)
+				offsets[v + 1] += offsets[v] ;
+			targets.resize(edges.size()) ;
+			weights.resize(edges.size()) ;
+			std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1) ;
+			for(std::size_t k = 0 ; k < edges.size() ; ++ k) {
+				const std::size_t e = fill[edges[k].from] ++ ;
+				targets[e] = edges[k].to ;
+				weights[e] = edges[k].weight ;
+			}
+			return 0 ;
+		}
+
+		// builds from the adjacency lists of G_vvii, keeping their order.
+		// returns 0 on success, -1 if an edge points out of the graph.
+		int build(const G_vvii &graph) {
+			const int n = (int) graph.size() ;
+			offsets.assign(n + 1, 0) ;
+			for(int v = 0 ; v < n ; ++ v)
+				offsets[v + 1] = offsets[v] + graph[v].size() ;
+			targets.resize(offsets[n]) ;
+			weights.resize(offsets[n]) ;
+			for(int v = 0 ; v < n ; ++ v) {
+				for(std::size_t i = 0 ; i < graph[v].size() ; ++ i) {
+					const gedge &e = graph[v][i] ;
+					if(e.second < 0 || e.second >= n) {
+						std::cerr << "Error, csr_graph edge " << v << " -> " << e.second
+							<< " is out of range [0, " << n << ")" << std::endl ;
+						*this = csr_graph() ;
+						return -1 ;
+					}
+					targets[offsets[v] + i] = e.second ;
+					weights[offsets[v] + i] = e.first ;
+				}
+			}
+			return 0 ;
+		}
+
+		// the graph with every edge turned around, for searching backwards
+		// from a target
+		csr_graph reversed() const {
+			const int n = vertex_count() ;
+			std::vector<graph_edge> edges ;
+			edges.reserve(targets.size()) ;
+			for(int v = 0 ; v < n ; ++ v)
+				for(std::size_t e = offsets[v] ; e < offsets[v + 1] ; ++ e)
+					edges.push_back(graph_edge{targets[e], v, weights[e]}) ;
+			csr_graph r ;
+			r.build(n, edges) ;
+			return r ;
+		}
 
-	class shortest_path_algo {
+		int vertex_count() const {
+			return (int) offsets.size() - 1 ;
+		}
+
+		std::size_t edge_count() const {
+			return targets.size() ;
+		}
+
+		// out-edges of v are the indexes [begin(v), end(v))
+		std::size_t begin(int v) const {
+			return offsets[v] ;
+		}
+
+		std::size_t end(int v) const {
+			return offsets[v + 1] ;
+		}
+
+		vertexid_t target(std::size_t e) const {
+			return targets[e] ;
+		}
+
+		distance_t weight(std::size_t e) const {
+			return weights[e] ;
+		}
+
+	private:
+		std::vector<std::size_t> offsets ;
+		std::vector<vertexid_t> targets ;
+		std::vector<distance_t> weights ;
+	} ;
+
+
+	// Priority queues for shortest_path_algo.  A queue policy has
+	//   prepare(nvertex)  size per-vertex state before a search
+	//   clear()           drop every entry, keeping the buffers
+	//   push(d, v)        offer v at distance d
+	//   pop()             remove and return a smallest (d, v)
+	//   empty()
+	// A policy may keep several entries of one vertex (the search skips
+	// the stale ones) or lower the key of the one it has.  Distances pushed
+	// are never below the last one popped, or 0 after clear(), which
+	// radix_heap_queue and dial_queue depend on.
+
+	// binary heap with lazy deletion: the original std::priority_queue
+	class binary_heap_queue {
+	public:
+		void prepare(int nvertex) {
+			(void) nvertex ;
+		}
+
+		void clear() {
+			Q.clear() ;
+		}
+
+		bool empty() const {
+			return Q.empty() ;
+		}
+
+		void push(distance_t d, vertexid_t v) {
+			Q.push(gedge(d, v)) ;
+		}
+
+		gedge pop() {
+			gedge e = Q.top() ;
+			Q.pop() ;
+			return e ;
+		}
+
+	private:
+		// clear() keeps the buffer of the underlying vector
+		struct queue_t : std::priority_queue<gedge, std::vector<gedge>,  std::greater<gedge> > {
+			void clear() {
+				c.clear() ;
+			}
+		} ;
+
+		queue_t Q ;
+	} ;
+
+	// Monotone radix heap (Ahuja, Mehlhorn, Orlin and Tarjan, 1990).  An
+	// entry lives in the bucket given by the highest bit where its distance
+	// differs from the last one popped, so bucket 0 holds entries equal to
+	// it.  pop() empties bucket 0 first; otherwise it takes the lowest
+	// non-empty bucket, makes its minimum the new last and spreads it over
+	// lower buckets.  Each entry moves down at most once per bit: O(log C)
+	// amortised per entry, with no comparisons between entries.
+	class radix_heap_queue {
+	public:
+		radix_heap_queue() : last(0), count(0) {}
+
+		void prepare(int nvertex) {
+			(void) nvertex ;
+		}
+
+		void clear() {
+			for(int b = 0 ; b < nbuckets ; ++ b)
+				buckets[b].clear() ;
+			last = 0 ;
+			count = 0 ;
+		}
+
+		bool empty() const {
+			return count == 0 ;
+		}
+
+		void push(distance_t d, vertexid_t v) {
+			buckets[bucket_of((unsigned int) d)].push_back(gedge(d, v)) ;
+			++ count ;
+		}
+
+		gedge pop() {
+			if(buckets[0].empty()) {
+				int b = 1 ;
+				while(buckets[b].empty())
+					++ b ;
+				unsigned int m = (unsigned int) buckets[b][0].first ;
+				for(std::size_t k = 1 ; k < buckets[b].size() ; ++ k)
+					if((unsigned int) buckets[b][k].first < m)
+						m = (unsigned int) buckets[b][k].first ;
+				last = m ;
+				// every entry lands in a bucket below b
+				for(std::size_t k = 0 ; k < buckets[b].size() ; ++ k)
+					buckets[bucket_of((unsigned int) buckets[b][k].first)].push_back(buckets[b][k]) ;
+				buckets[b].clear() ;
+			}
+			gedge e = buckets[0].back() ;
+			buckets[0].pop_back() ;
+			-- count ;
+			return e ;
+		}
+
+	private:
+		enum { nbuckets = 33 } ;
+
+		int bucket_of(unsigned int d) const {
+			return d == last ? 0 : 32 - __builtin_clz(d ^ last) ;
+		}
+
+		std::vector<gedge> buckets[nbuckets] ;
+		unsigned int last ;
+		std::size_t count ;
+	} ;
+
+	// Dial's bucket queue (1969): one bucket per distance on a ring.  Live
+	// distances never span more than the largest edge weight, so a ring
+	// longer than that maps each bucket to one distance.  pop() walks the
+	// ring from the last distance popped, O(1) amortised plus the empty
+	// buckets skipped, which is at most the largest weight per pop.  The
+	// ring starts small and doubles when a push lands beyond it, so the
+	// largest weight need not be known up front.  Best for small weights.
+	class dial_queue {
+	public:
+		dial_queue() : ring(16), cur(0), count(0) {}
+
+		void prepare(int nvertex) {
+			(void) nvertex ;
+		}
+
+		// walks only the buckets from cur to the last entry left, not the
+		// whole ring
+		void clear() {
+			for(distance_t d = cur ; count > 0 ; ++ d) {
+				std::vector<vertexid_t> &bucket = ring[d & (ring.size() - 1)] ;
+				count -= bucket.size() ;
+				bucket.clear() ;
+			}
+			cur = 0 ;
+		}
+
+		bool empty() const {
+			return count == 0 ;
+		}
+
+		// d below cur (a negative weight or an overflowed sum) would
+		// make grow() loop on the wrapped span: it asserts, and without
+		// assertions is clamped to cur
+		void push(distance_t d, vertexid_t v) {
+			assert(d >= cur) ;
+			if(d < cur)
+				d = cur ;
+			if((std::size_t) (d - cur) >= ring.size())
+				grow((std::size_t) (d - cur)) ;
+			ring[d & (ring.size() - 1)].push_back(v) ;
+			++ count ;
+		}
+
+		gedge pop() {
+			std::size_t b = cur & (ring.size() - 1) ;
+			while(ring[b].empty()) {
+				++ cur ;
+				b = cur & (ring.size() - 1) ;
+			}
+			vertexid_t v = ring[b].back() ;
+			ring[b].pop_back() ;
+			-- count ;
+			return gedge(cur, v) ;
+		}
+
+	private:
+		// resizes the ring to a power of two above span
+		void grow(std::size_t span) {
+			std::size_t size = ring.size() ;
+			while(size <= span)
+				size *= 2 ;
+			std::vector<std::vector<vertexid_t> > old(size) ;
+			old.swap(ring) ;
+			// distance of old bucket b: the one in [cur, cur + old size)
+			for(std::size_t b = 0 ; b < old.size() ; ++ b) {
+				if(old[b].empty())
+					continue ;
+				const distance_t d = cur + (distance_t) ((b - (cur & (old.size() - 1))) & (old.size() - 1)) ;
+				ring[d & (ring.size() - 1)].swap(old[b]) ;
+			}
+		}
+
+		std::vector<std::vector<vertexid_t> > ring ;   // size is a power of two
+		distance_t cur ;                               // the last distance popped
+		std::size_t count ;
+	} ;
+
+	// Arity-ary heap indexed by vertex, with decrease-key: at most one entry
+	// per vertex, so the queue never grows past the vertices reached.  A
+	// wider node makes the heap shallower and a sift-down scans children
+	// that share cache lines.
+	template <int Arity = 4>
+	class indexed_heap_queue {
+	public:
+		void prepare(int nvertex) {
+			if((int) pos.size() != nvertex) {
+				heap.clear() ;
+				pos.assign(nvertex, -1) ;
+			}
+		}
+
+		void clear() {
+			for(std::size_t k = 0 ; k < heap.size() ; ++ k)
+				pos[heap[k].second] = -1 ;
+			heap.clear() ;
+		}
+
+		bool empty() const {
+			return heap.empty() ;
+		}
+
+		// inserts v, or lowers its distance if it is already queued
+		void push(distance_t d, vertexid_t v) {
+			int k = pos[v] ;
+			if(k < 0) {
+				k = (int) heap.size() ;
+				heap.push_back(gedge(d, v)) ;
+			}
+			else if(d < heap[k].first) {
+				heap[k].first = d ;
+			}
+			else {
+				return ;
+			}
+			sift_up(k) ;
+		}
+
+		gedge pop() {
+			gedge top = heap[0] ;
+			pos[top.second] = -1 ;
+			const gedge last = heap.back() ;
+			heap.pop_back() ;
+			if(! heap.empty()) {
+				heap[0] = last ;
+				pos[last.second] = 0 ;
+				sift_down(0) ;
+			}
+			return top ;
+		}
+
+	private:
+		void sift_up(int k) {
+			const gedge e = heap[k] ;
+			while(k > 0) {
+				const int parent = (k - 1) / Arity ;
+				if(! (e < heap[parent]))
+					break ;
+				heap[k] = heap[parent] ;
+				pos[heap[k].second] = k ;
+				k = parent ;
+			}
+			heap[k] = e ;
+			pos[e.second] = k ;
+		}
+
+		void sift_down(int k) {
+			const gedge e = heap[k] ;
+			const int n = (int) heap.size() ;
+			for(;;) {
+				const int first = k * Arity + 1 ;
+				if(first >= n)
+					break ;
+				int best = first ;
+				const int stop = first + Arity < n ? first + Arity : n ;
+				for(int c = first + 1 ; c < stop ; ++ c)
+					if(heap[c] < heap[best])
+						best = c ;
+				if(! (heap[best] < e))
+					break ;
+				heap[k] = heap[best] ;
+				pos[heap[k].second] = k ;
+				k = best ;
+			}
+			heap[k] = e ;
+			pos[e.second] = k ;
+		}
+
+		std::vector<gedge> heap ;
+		std::vector<int> pos ;   // slot of each vertex in heap, -1 if not queued
+	} ;
+
+	// Single-source shortest paths.  The per-vertex arrays and the queue
+	// are kept between calls: a vertex's entries are only valid if its
+	// stamp equals the current generation, so a new search starts by
+	// bumping the generation instead of refilling O(V) arrays, and a short
+	// point-to-point query only pays for the vertices it touches.
+	//
+	// Queue is the priority queue policy; see binary_heap_queue.  Every
+	// policy gives the same distances, paths may differ between equally
+	// short ones.
+	template <class Queue = binary_heap_queue>
+	class basic_shortest_path_algo {
 	public: 
-		void initialize(const int totalvertex, const int fromvertex_id)  {
-			Dsource = std::vector<int>(totalvertex, 987654321) ;
-			Dsource[fromvertex_id] = 0 ;
-			previous_vertex = std::vector<int>(totalvertex, -1) ;
+		enum { unreached = 987654321 } ; // distance of a vertex not reached
 
-			v_visited = std::vector<bool>(totalvertex, false) ; 
+		basic_shortest_path_algo() : fid(-1), generation(0), nscanned(0) {}
 
-	//		Q.push(gedge(0, 0)) ;
+		// starts a search from fromvertex_id over totalvertex vertices.  The
+		// buffers are only reallocated when the vertex count changes.
+		void initialize(const int totalvertex, const int fromvertex_id)  {
+			if((int) Dsource.size() != totalvertex) {
+				Dsource.assign(totalvertex, unreached) ;
+				previous_vertex.assign(totalvertex, -1) ;
+				stamp.assign(totalvertex, 0) ;
+				stamp_back.clear() ;
+				expanded.clear() ;
+				generation = 0 ;
+			}
+			if(++ generation == 0) {
+				// the counter wrapped: old stamps could look current
+				std::fill(stamp.begin(), stamp.end(), 0) ;
+				std::fill(stamp_back.begin(), stamp_back.end(), 0) ;
+				std::fill(expanded.begin(), expanded.end(), 0) ;
+				generation = 1 ;
+			}
+			nscanned = 0 ;
+			Q.prepare(totalvertex) ;
+			Q.clear() ;
+			touch(fromvertex_id) ;
+			Dsource[fromvertex_id] = 0 ;
 
 			fid = fromvertex_id ;
 		}
 
 		// vvii as graph structure, 
 		int Dijkstra(const G_vvii &graph, int fromid, int toid = -1) {
-			int distance = -1 ;
-			initialize(graph.size() , fromid) ;
+			return Dijkstra_imp(graph, fromid, toid) ;
+		}
+
+		// same search on a csr_graph; the results are those of the G_vvii
+		// the graph was built from
+		int Dijkstra(const csr_graph &graph, int fromid, int toid = -1) {
+			return Dijkstra_imp(graph, fromid, toid) ;
+		}
+
+		// point-to-point search from both ends: forward on graph from fromid
+		// and backward on reverse, which must be graph.reversed(), from
+		// toid, one vertex each in turn.  mu is the shortest path seen
+		// through an edge into the other side.  The search stops once the
+		// last keys popped on the two sides add up to mu: any path through a
+		// vertex neither side has settled is at least that long.  The two
+		// balls meet about half way, and cover much less than one ball with
+		// the whole distance as its radius.
+		// Afterwards distance(toid) and print_path(toid) give the result.
+		// Other vertices are left as after Dijkstra(graph, fromid, toid):
+		// their distances are only upper bounds.
+		int Dijkstra_bidirectional(const csr_graph &graph, const csr_graph &reverse, int fromid, int toid) {
+			const int n = graph.vertex_count() ;
+			if(reverse.vertex_count() != n) {
+				std::cerr << "Error Dijkstra_bidirectional:  the reverse graph has " << reverse.vertex_count()
+					<< " vertices, the graph " << n << std::endl ;
+				return -1 ;
+			}
+			if(fromid < 0 || fromid >= n || toid < 0 || toid >= n) {
+				std::cerr << "Error Dijkstra_bidirectional:  vertex id " << (fromid < 0 || fromid >= n ? fromid : toid)
+					<< " is out of range. " << std::endl ;
+				return -1 ;
+			}
+			initialize(n, fromid) ;
+			if((int) stamp_back.size() != n) {
+				Dtarget.assign(n, unreached) ;
+				next_vertex.assign(n, -1) ;
+				stamp_back.assign(n, 0) ;
+			}
+			Qb.prepare(n) ;
+			Qb.clear() ;
+			touch_back(toid) ;
+			Dtarget[toid] = 0 ;
+			Q.push(0, fromid) ;
+			Qb.push(0, toid) ;
+
+			int mu = fromid == toid ? 0 : (int) unreached ;
+			int meet = toid ;
+			// keys popped last: no entry left in either queue is smaller
+			int top = 0, top_back = 0 ;
+			while(!Q.empty() && !Qb.empty()) {
+				gedge e = Q.pop() ;
+				top = e.first ;
+				if(top + top_back >= mu)
+					break ;
+				int vid = e.second ;
+				if(e.first <= Dsource[vid]) {
+					++ nscanned ;
+					for_each_out_edge(graph, vid, [&](vertexid_t to, distance_t w) {
+						if(Dsource[vid] + w < current(to)) {
+							touch(to) ;
+							Dsource[to] = Dsource[vid] + w ;
+							Q.push(Dsource[to], to) ;
+							previous_vertex[to] = vid ;
+						}
+						const int f = current(to), b = current_back(to) ;
+						if(f != unreached && b != unreached && f + b < mu) {
+							mu = f + b ;
+							meet = to ;
+						}
+					}) ;
+				}
+
+				e = Qb.pop() ;
+				top_back = e.first ;
+				if(top + top_back >= mu)
+					break ;
+				vid = e.second ;
+				if(e.first <= Dtarget[vid]) {
+					++ nscanned ;
+					for_each_out_edge(reverse, vid, [&](vertexid_t to, distance_t w) {
+						if(Dtarget[vid] + w < current_back(to)) {
+							touch_back(to) ;
+							Dtarget[to] = Dtarget[vid] + w ;
+							Qb.push(Dtarget[to], to) ;
+							next_vertex[to] = vid ;
+						}
+						const int f = current(to), b = current_back(to) ;
+						if(f != unreached && b != unreached && f + b < mu) {
+							mu = f + b ;
+							meet = to ;
+						}
+					}) ;
+				}
+			}
+			if(mu == unreached)
+				return 0 ; // toid is not reachable
+
+			// Continue the forward tree along the backward one to toid.  Start
+			// at the last vertex of the backward path whose forward distance
+			// is already exact: with zero weights, the forward path to an
+			// earlier one may run through a later one, and relinking it would
+			// close a cycle.
+			int v = meet ;
+			for(int u = meet ; u != toid ; ) {
+				u = next_vertex[u] ;
+				if(current(u) != unreached && current(u) + Dtarget[u] == mu)
+					v = u ;
+			}
+			while(v != toid) {
+				const int next = next_vertex[v] ;
+				touch(next) ;
+				Dsource[next] = Dsource[v] + (Dtarget[v] - Dtarget[next]) ;
+				previous_vertex[next] = v ;
+				v = next ;
+			}
+			return 0 ;
+		}
+
+		// A* from fromid to toid: Dijkstra keyed on distance + h(v, toid),
+		// where h(v, toid) is a lower bound on the distance from v to toid,
+		// so the search heads for the target instead of growing a ball.  Any
+		// such (admissible) h gives the exact distance and path to toid.
+		// A vertex is pushed with at least the key of the vertex it was
+		// reached from (pathmax), so the keys popped never decrease, as
+		// radix_heap_queue and dial_queue need.  A consistent h,
+		// h(u, t) <= w(u, v) + h(v, t), expands each vertex once; with an
+		// inconsistent one a vertex is expanded again when a shorter path
+		// to it turns up.  h = 0 is Dijkstra; see euclidean_heuristic.
+		template <class Heuristic>
+		int Astar(const G_vvii &graph, int fromid, int toid, Heuristic h) {
+			return Astar_imp(graph, fromid, toid, h) ;
+		}
+
+		template <class Heuristic>
+		int Astar(const csr_graph &graph, int fromid, int toid, Heuristic h) {
+			return Astar_imp(graph, fromid, toid, h) ;
+		}
+
+		// vertices whose out-edges the last search scanned, both sides of a
+		// bidirectional one
+		int scanned() const {
+			return nscanned ;
+		}
+
+		int print_path(int toid) {
+			if(toid < 0 || toid >= Dsource.size()) 
+			{
+				std::cerr << "Error print_path:  vertex id " << toid << " is out of range. " << std::endl ;
+				return -1 ;
+			}
+		
+			std::cout << "shortest path from vertex " << fid << " to " << toid << " has distance  " << distance(toid) << std::endl ;
+
+			int pvid = previous(toid) ;
+			std::cout << toid  ;
+			while(pvid >=0) {
+				std::cout << " <== " << pvid ; 
+				pvid = previous(pvid) ;
+			}
+			std::cout << std::endl ;
+			return 0; 
+		}
+
+		// distance from the source of the last search, unreached if the
+		// search did not get to toid; -1 if toid is out of range
+		int distance(int toid) const {
+			if(toid < 0 || toid >= (int) Dsource.size()) 
+				return -1 ;
+			return current(toid) ;
+		}
+
+	private: 
+		int current(int vid) const {
+			return stamp[vid] == generation ? Dsource[vid] : (int) unreached ;
+		}
+
+		int previous(int vid) const {
+			return stamp[vid] == generation ? previous_vertex[vid] : -1 ;
+		}
+
+		int current_back(int vid) const {
+			return stamp_back[vid] == generation ? Dtarget[vid] : (int) unreached ;
+		}
+
+		void touch_back(int vid) {
+			if(stamp_back[vid] != generation) {
+				stamp_back[vid] = generation ;
+				Dtarget[vid] = unreached ;
+				next_vertex[vid] = -1 ;
+			}
+		}
+
+		// makes vid part of the current search, unreached until relaxed
+		void touch(int vid) {
+			if(stamp[vid] != generation) {
+				stamp[vid] = generation ;
+				Dsource[vid] = unreached ;
+				previous_vertex[vid] = -1 ;
+			}
+		}
 
-			Dsource[fromid] = 0 ;
-			Q.push(ii(0, fromid)) ;
+		template <class Graph>
+		int Dijkstra_imp(const Graph &graph, int fromid, int toid) {
+			const int n = vertex_count(graph) ;
+			if(fromid < 0 || fromid >= n) {
+				std::cerr << "Error Dijkstra:  vertex id " << fromid << " is out of range. " << std::endl ;
+				return -1 ;
+			}
+			initialize(n, fromid) ;
+			Q.push(0, fromid) ;
 
 			while(!Q.empty())  {
-				ii e = Q.top() ;
-				Q.pop() ;
+				ii e = Q.pop() ;
 
 				int distance = e.first ; 
 				int vid = e.second ;
@@ -57,41 +693,79 @@ namespace commonlibs {
 				// check if visited.  We don't need a visited flag array because priority queue guarantees that 
 				///  overall distance  > D[v], because the edges are fetched in ascending order based on their length 
 				if(distance <= Dsource[vid]) {
-					for (int i = 0 ; i < graph[vid].size() ; ++ i) { 
-						const gedge & eout = graph[vid][i] ;
-						if(Dsource[vid] + eout.first < Dsource[eout.second]) // 
+					++ nscanned ;
+					for_each_out_edge(graph, vid, [&](vertexid_t to, distance_t w) {
+						if(Dsource[vid] + w < current(to)) // 
 						{
-							Dsource[eout.second] = Dsource[vid] + eout.first ;
-							Q.push(ii(Dsource[eout.second], eout.second)) ;
-							previous_vertex[eout.second] = vid ;
+							touch(to) ;
+							Dsource[to] = Dsource[vid] + w ;
+							Q.push(Dsource[to], to) ;
+							previous_vertex[to] = vid ;
 						}
-					} // for each outgoing edge
+					}) ; // for each outgoing edge
 				} // if ! visited
 			} //  while 
 
 			return 0 ;
 		}
 
-		int print_path(int toid) {
-			if(toid < 0 || toid >= Dsource.size()) 
-			{
-				std::cerr << "Error print_path:  vertex id " << toid << " is out of range. " << std::endl ;
+		template <class Graph, class Heuristic>
+		int Astar_imp(const Graph &graph, int fromid, int toid, Heuristic &h) {
+			const int n = vertex_count(graph) ;
+			if(fromid < 0 || fromid >= n || toid < 0 || toid >= n) {
+				std::cerr << "Error Astar:  vertex id " << (fromid < 0 || fromid >= n ? fromid : toid)
+					<< " is out of range. " << std::endl ;
 				return -1 ;
 			}
-		
-			std::cout << "shortest path from vertex " << fid << " to " << toid << " has distance  " << Dsource[toid] << std::endl ;
+			initialize(n, fromid) ;
+			if((int) expanded.size() != n)
+				expanded.assign(n, 0) ;
+			Q.push(h(fromid, toid), fromid) ;
 
-			int pvid = previous_vertex[toid] ;
-			std::cout << toid  ;
-			while(pvid >=0) {
-				std::cout << " <== " << pvid ; 
-				pvid = previous_vertex[pvid] ;
+			while(!Q.empty())  {
+				gedge e = Q.pop() ;
+				int vid = e.second ;
+				if(vid == toid)
+					break ;
+				// keys are not distance + h after pathmax, so tell stale
+				// entries by whether vid was expanded at its current distance
+				if(expanded[vid] == generation)
+					continue ;
+				expanded[vid] = generation ;
+				++ nscanned ;
+				for_each_out_edge(graph, vid, [&](vertexid_t to, distance_t w) {
+					if(Dsource[vid] + w < current(to)) {
+						touch(to) ;
+						Dsource[to] = Dsource[vid] + w ;
+						expanded[to] = 0 ;
+						const distance_t key = Dsource[to] + h(to, toid) ;
+						Q.push(key < e.first ? e.first : key, to) ;
+						previous_vertex[to] = vid ;
+					}
+				}) ;
 			}
-			std::cout << std::endl ;
-			return 0; 
+			return 0 ;
 		}
 
-	private: 
+		static int vertex_count(const G_vvii &graph) {
+			return (int) graph.size() ;
+		}
+
+		static int vertex_count(const csr_graph &graph) {
+			return graph.vertex_count() ;
+		}
+
+		template <class Visit>
+		static void for_each_out_edge(const G_vvii &graph, int vid, Visit visit) {
+			for (std::size_t i = 0 ; i < graph[vid].size() ; ++ i) 
+				visit(graph[vid][i].second, graph[vid][i].first) ;
+		}
+
+		template <class Visit>
+		static void for_each_out_edge(const csr_graph &graph, int vid, Visit visit) {
+			for (std::size_t e = graph.begin(vid) ; e < graph.end(vid) ; ++ e) 
+				visit(graph.target(e), graph.weight(e)) ;
+		}
 
 		int fid ;
 		// distance from source 
@@ -102,13 +776,53 @@ namespace commonlibs {
 
 		std::vector<gedge> v_edges ;
 
-		// for non-queue based implementation 
-		std::vector<bool> v_visited ;
+		// Dsource and previous_vertex of a vertex are only valid if its
+		// stamp is the current generation
+		std::vector<unsigned int> stamp ;
+		unsigned int generation ;
 		// 
-		std::priority_queue<gedge, std::vector<gedge>,  std::greater<gedge> > Q ;
+		Queue Q ;
+
+		// the backward side of Dijkstra_bidirectional: distance to the
+		// target and the next vertex towards it, valid under stamp_back
+		std::vector<int> Dtarget ;
+		std::vector<int> next_vertex ;
+		std::vector<unsigned int> stamp_back ;
+		Queue Qb ;
+
+		// Astar: vertices expanded at their current distance hold the
+		// generation
+		std::vector<unsigned int> expanded ;
+
+		int nscanned ;
 
 	}; 
 
+	// Dijkstra with the binary heap it always had
+	typedef basic_shortest_path_algo<binary_heap_queue> shortest_path_algo ;
+
+	// A* heuristic for graphs with vertex coordinates: the straight-line
+	// distance to the target times scale, rounded down.  It is admissible,
+	// and consistent, if no edge costs less than scale times its
+	// straight-line length, so
+	// scale is the lowest cost per unit of length in the graph (one over
+	// the top speed when weights are travel times).  Keeps references to
+	// x and y.
+	class euclidean_heuristic {
+	public:
+		euclidean_heuristic(const std::vector<double> &x, const std::vector<double> &y, double scale = 1.0)
+			: x(x), y(y), scale(scale) {}
+
+		distance_t operator()(vertexid_t v, vertexid_t target) const {
+			return (distance_t) (scale * std::hypot(x[v] - x[target], y[v] - y[target])) ;
+		}
+
+	private:
+		const std::vector<double> &x ;
+		const std::vector<double> &y ;
+		double scale ;
+	} ;
+
 
 } 
 
@@ -0,0 +1,94 @@
+#ifndef __COMMONLIBS_ARENA_HPP
+
+#define __COMMONLIBS_ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace commonlibs {
+// bump allocator for fixed-size nodes addressed by 32-bit handles.
+//
+// Nodes live in chunks of 2^ChunkBits elements; a handle is
+// (chunk << ChunkBits) | offset, so handles stay valid while the arena
+// grows and are half the size of a pointer.  There is no per-node free:
+// clear() drops every chunk at once, and containers that need to discard
+// part of their nodes copy the survivors into a fresh arena and swap.
+template <class T, unsigned int ChunkBits = 16>
+class chunk_arena {
+public:
+	typedef uint32_t handle_t ;
+	enum : handle_t { null_handle = 0xffffffffu } ;
+	enum : std::size_t { chunk_size = (std::size_t) 1 << ChunkBits } ;
+
+	chunk_arena() : next_(0) {}
+
+	chunk_arena(const chunk_arena &) = delete ;
+	chunk_arena & operator=(const chunk_arena &) = delete ;
+	// the moved-from arena is left empty, ready for allocate()
+	chunk_arena(chunk_arena &&other) : chunks(std::move(other.chunks)), next_(other.next_) {
+		other.clear() ;
+	}
+
+	chunk_arena & operator=(chunk_arena &&other) {
+		if(this != &other) {
+			chunks = std::move(other.chunks) ;
+			next_ = other.next_ ;
+			other.clear() ;
+		}
+		return *this ;
+	}
+
+	// returns the handle of a new value-initialised node, or null_handle
+	// once all 2^32 - 1 handles are taken
+	handle_t allocate() {
+		if(next_ >= (std::size_t) null_handle) {
+			return null_handle ;
+		}
+		if(next_ == chunks.size() * chunk_size) {
+			chunks.push_back(std::unique_ptr<T[]>(new T[chunk_size]())) ;
+		}
+		return (handle_t) next_ ++ ;
+	}
+
+	T & operator[](handle_t h) {
+		return chunks[h >> ChunkBits][h & (chunk_size - 1)] ;
+	}
+
+	const T & operator[](handle_t h) const {
+		return chunks[h >> ChunkBits][h & (chunk_size - 1)] ;
+	}
+
+	// number of nodes handed out so far
+	std::size_t size() const {
+		return next_ ;
+	}
+
+	std::size_t chunk_count() const {
+		return chunks.size() ;
+	}
+
+	std::size_t bytes_reserved() const {
+		return chunks.size() * chunk_size * sizeof(T) ;
+	}
+
+	// releases every chunk; all handles become invalid
+	void clear() {
+		chunks.clear() ;
+		next_ = 0 ;
+	}
+
+	void swap(chunk_arena &other) {
+		chunks.swap(other.chunks) ;
+		std::swap(next_, other.next_) ;
+	}
+
+private:
+	std::vector<std::unique_ptr<T[]> > chunks ;
+	std::size_t next_ ;
+} ;
+}
+
+#endif
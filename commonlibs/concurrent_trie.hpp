@@ -0,0 +1,369 @@
+#ifndef __COMMONLIBS_CONCURRENT_TRIE_HPP
+
+#define __COMMONLIBS_CONCURRENT_TRIE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cctype>
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace commonlibs {
+// Epoch-based reclamation for lock-free structures.  A thread holds an
+// epoch_domain::guard for the length of one operation, which announces the
+// global epoch it started in.  Unlinked objects are retired with the epoch
+// current at unlink time and freed once every active guard announces a
+// later epoch: any thread that could still hold a pointer to them started
+// before the unlink and is still inside its guard.
+//
+// Up to max_threads guards at a time get a slot of their own.  Guards past
+// that never wait: they share one overflow count, and nothing is freed while
+// it is nonzero, so a burst of threads delays reclamation instead of
+// blocking.
+class epoch_domain {
+public:
+	enum { max_threads = 128 } ;
+
+	epoch_domain() : global(1), overflow(0) {
+		for(int k = 0 ; k < max_threads ; ++ k)
+			slots[k].store(0, std::memory_order_relaxed) ;
+	}
+
+	~epoch_domain() {
+		for(std::size_t k = 0 ; k < retired.size() ; ++ k)
+			retired[k].free(retired[k].p) ;
+	}
+
+	epoch_domain(const epoch_domain &) = delete ;
+	epoch_domain & operator=(const epoch_domain &) = delete ;
+
+	class guard {
+	public:
+		explicit guard(epoch_domain &d_) : d(d_) {
+			slot = d.enter() ;
+		}
+		~guard() {
+			if(slot < 0)
+				d.overflow.fetch_sub(1, std::memory_order_release) ;
+			else
+				d.slots[slot].store(0, std::memory_order_release) ;
+		}
+		guard(const guard &) = delete ;
+		guard & operator=(const guard &) = delete ;
+	private:
+		epoch_domain &d ;
+		int slot ;
+	} ;
+
+	// hands p to the domain; free(p) runs once no guard can still see it.
+	// Callers of retire/collect must not run concurrently with each other.
+	template <class T>
+	void retire(T *p) {
+		retired.push_back(retired_t(p, global.load(), &destroy<T>)) ;
+		if(retired.size() >= 64)
+			collect() ;
+	}
+
+	// frees what no active guard can reach; returns the number freed
+	std::size_t collect() {
+		global.fetch_add(1) ;
+		// pairs with the fence in enter(): unlinks are visible before the scan
+		std::atomic_thread_fence(std::memory_order_seq_cst) ;
+		// an overflow guard may have started in any epoch still retired
+		uint64_t oldest = overflow.load() > 0 ? 0 : UINT64_MAX ;
+		for(int k = 0 ; k < max_threads ; ++ k) {
+			const uint64_t e = slots[k].load() ;
+			if(e != 0 && e < oldest)
+				oldest = e ;
+		}
+		std::size_t kept = 0, freed = 0 ;
+		for(std::size_t k = 0 ; k < retired.size() ; ++ k) {
+			if(retired[k].epoch < oldest) {
+				retired[k].free(retired[k].p) ;
+				++ freed ;
+			}
+			else {
+				retired[kept ++] = retired[k] ;
+			}
+		}
+		retired.erase(retired.begin() + kept, retired.end()) ;
+		return freed ;
+	}
+
+	std::size_t pending() const {
+		return retired.size() ;
+	}
+
+private:
+	struct retired_t {
+		void *p ;
+		uint64_t epoch ;
+		void (*free)(void *) ;
+		retired_t(void *p_, uint64_t e, void (*f)(void *)) : p(p_), epoch(e), free(f) {}
+	} ;
+
+	template <class T>
+	static void destroy(void *p) {
+		delete (T *) p ;
+	}
+
+	// claims a free slot and announces the current epoch in it; with every
+	// slot taken, joins the overflow count and returns -1
+	int enter() {
+		const int start = (int) (std::hash<std::thread::id>()(std::this_thread::get_id()) % max_threads) ;
+		int s = -1 ;
+		for(int k = 0 ; k < max_threads && s < 0 ; ++ k) {
+			uint64_t expected = 0 ;
+			if(slots[(start + k) % max_threads].compare_exchange_strong(expected, global.load()))
+				s = (start + k) % max_threads ;
+		}
+		if(s < 0)
+			overflow.fetch_add(1) ;
+		// the announcement must be visible before any pointer is read
+		std::atomic_thread_fence(std::memory_order_seq_cst) ;
+		return s ;
+	}
+
+	std::atomic<uint64_t> global ;
+	std::atomic<uint64_t> slots[max_threads] ; // announced epoch, 0 if free
+	std::atomic<int> overflow ;                // guards without a slot
+	std::vector<retired_t> retired ;
+} ;
+
+// Trie for many concurrent readers and writers, with the counting interface
+// of Vertex (letters only, case ignored) and word removal.
+//
+// Readers and inserters take no lock.  A missing child is built privately
+// and installed with one compare-and-swap on the parent's slot, and a
+// thread that loses the race adopts the winner's node.  Counters are atomic
+// and nodes are never written after publication except through atomics, so
+// a reader sees either no child or a complete one.
+//
+// removeWord decrements the count and prunes the nodes left with no word
+// and no child.  A node is pruned by sealing its empty child slots (no
+// insert can hang a child on it any more), marking its word count dead (no
+// insert can count a word in it), then unlinking it from its parent.  An
+// insert that meets a sealed slot or a dead count starts over from the root.
+// Unlinked nodes go to an epoch_domain and are freed once no reader can
+// still be on them.  Removals are serialised among themselves by a mutex
+// that readers and inserters never take.
+class concurrent_trie {
+public:
+	enum { num_leaves = 26 } ;
+
+	concurrent_trie() {}
+
+	~concurrent_trie() {
+		destroy(&root) ;
+	}
+
+	concurrent_trie(const concurrent_trie &) = delete ;
+	concurrent_trie & operator=(const concurrent_trie &) = delete ;
+
+	// adds one occurrence of the word.  only the alphabet is allowed, case
+	// is ignored; a word with another character is cut there, as in Vertex.
+	// returns: the number of occurrences after the add, 0 if it was cut
+	int addWord(const char *p_word, size_t size) {
+		if(p_word == NULL || size == 0) {
+			return 0 ;
+		}
+		epoch_domain::guard g(epochs) ;
+		for(;;) {
+			int r = try_add(p_word, size) ;
+			if(r >= 0)
+				return r ;
+			std::this_thread::yield() ; // a removal is pruning our path
+		}
+	}
+
+	// number of times the word was added and not removed; 0 if absent
+	int countWords(const char *p_word, size_t size) const {
+		epoch_domain::guard g(epochs) ;
+		const node_t *cur = find(p_word, size) ;
+		if(cur == NULL)
+			return 0 ;
+		const int w = cur->words.load(std::memory_order_acquire) ;
+		return w == dead ? 0 : w ;
+	}
+
+	// number of distinct letters following the prefix; 0 if absent
+	int countPrefixes(const char *p_word, size_t size) const {
+		epoch_domain::guard g(epochs) ;
+		const node_t *cur = find(p_word, size) ;
+		return cur == NULL ? 0 : cur->prefixes.load(std::memory_order_acquire) ;
+	}
+
+	// removes one occurrence of the word.
+	// returns: the number of occurrences left, -1 if the word was absent
+	int removeWord(const char *p_word, size_t size) {
+		if(p_word == NULL || size == 0) {
+			return -1 ;
+		}
+		std::lock_guard<std::mutex> lock(remove_lock) ;
+		epoch_domain::guard g(epochs) ;
+		std::vector<node_t *> path(size) ; // path[k]: node before letter k
+		std::vector<int> letters(size) ;
+		node_t *cur = &root ;
+		for(size_t k = 0 ; k < size ; ++ k) {
+			const int c = letter(p_word[k]) ;
+			if(c < 0) {
+				std::cerr << "only alphbets are allowed" << std::endl ;
+				return -1 ;
+			}
+			path[k] = cur ;
+			letters[k] = c ;
+			node_t *next = cur->edges[c].load(std::memory_order_acquire) ;
+			if(next == NULL || next == sealed())
+				return -1 ;
+			cur = next ;
+		}
+		int w = cur->words.load() ;
+		do {
+			if(w <= 0)
+				return -1 ;
+		} while(! cur->words.compare_exchange_weak(w, w - 1)) ;
+		if(w - 1 > 0)
+			return w - 1 ;
+		// prune upwards while the node holds nothing
+		for(size_t k = size ; k > 0 && cur != &root ; -- k) {
+			if(! kill(cur))
+				break ;
+			// only removals unlink and they hold the lock: the slot is still cur
+			path[k - 1]->edges[letters[k - 1]].store(NULL) ;
+			path[k - 1]->prefixes.fetch_sub(1) ;
+			epochs.retire(cur) ;
+			cur = path[k - 1] ;
+		}
+		return 0 ;
+	}
+
+	// frees the removed nodes that no reader can reach any more; returns
+	// the number freed.  removeWord also does this every 64 nodes.
+	std::size_t collect() {
+		std::lock_guard<std::mutex> lock(remove_lock) ;
+		return epochs.collect() ;
+	}
+
+	// removed nodes waiting to be freed
+	std::size_t pending_reclaim() const {
+		return epochs.pending() ;
+	}
+
+private:
+	struct node_t {
+		std::atomic<int> words ;
+		std::atomic<int> prefixes ;
+		std::atomic<node_t *> edges[num_leaves] ;
+		node_t() : words(0), prefixes(0) {
+			for(int i = 0 ; i < num_leaves ; ++ i)
+				edges[i].store(NULL, std::memory_order_relaxed) ;
+		}
+	} ;
+
+	enum { dead = -1 } ; // words of a node being pruned
+
+	// marks a child slot that may not be filled; never a node address
+	static node_t * sealed() {
+		return (node_t *) (uintptr_t) 1 ;
+	}
+
+	static int letter(char ch) {
+		if(! ::isalpha((unsigned char) ch)) {
+			return -1 ;
+		}
+		return ::tolower((unsigned char) ch) - 'a' ;
+	}
+
+	// node for p_word, or NULL.  The root never holds a word, so NULL for
+	// a non-letter gives the answers of Vertex.
+	const node_t * find(const char *p_word, size_t size) const {
+		const node_t *cur = &root ;
+		if(p_word == NULL)
+			return cur ;
+		for(size_t k = 0 ; k < size ; ++ k) {
+			const int c = letter(p_word[k]) ;
+			if(c < 0) {
+				std::cerr << "only alphbets are allowed" << std::endl ;
+				return NULL ;
+			}
+			const node_t *next = cur->edges[c].load(std::memory_order_acquire) ;
+			if(next == NULL || next == sealed())
+				return NULL ;
+			cur = next ;
+		}
+		return cur ;
+	}
+
+	// one attempt; -1 if it ran into a node being pruned
+	int try_add(const char *p_word, size_t size) {
+		node_t *cur = &root ;
+		for(size_t k = 0 ; k < size ; ++ k) {
+			const int c = letter(p_word[k]) ;
+			if(c < 0) {
+				std::cerr << "only alphbets are allowed" << std::endl ;
+				return 0 ;
+			}
+			node_t *next = cur->edges[c].load(std::memory_order_acquire) ;
+			if(next == sealed())
+				return -1 ;
+			if(next == NULL) {
+				node_t *fresh = new node_t() ;
+				if(cur->edges[c].compare_exchange_strong(next, fresh, std::memory_order_acq_rel)) {
+					cur->prefixes.fetch_add(1) ;
+					next = fresh ;
+				}
+				else {
+					delete fresh ; // never published
+					if(next == sealed())
+						return -1 ;
+				}
+			}
+			cur = next ;
+		}
+		int w = cur->words.load() ;
+		do {
+			if(w == dead)
+				return -1 ;
+		} while(! cur->words.compare_exchange_weak(w, w + 1)) ;
+		return w + 1 ;
+	}
+
+	// seals the empty slots of n and marks it dead; false, with n left as
+	// it was, if it still has a child or a word
+	bool kill(node_t *n) {
+		int k = 0 ;
+		for( ; k < num_leaves ; ++ k) {
+			node_t *expected = NULL ;
+			if(! n->edges[k].compare_exchange_strong(expected, sealed()))
+				break ;
+		}
+		int zero = 0 ;
+		if(k == num_leaves && n->words.compare_exchange_strong(zero, (int) dead))
+			return true ;
+		while(k > 0)
+			n->edges[-- k].store(NULL, std::memory_order_release) ;
+		return false ;
+	}
+
+	static void destroy(node_t *n) {
+		for(int k = 0 ; k < num_leaves ; ++ k) {
+			node_t *c = n->edges[k].load() ;
+			if(c != NULL && c != sealed()) {
+				destroy(c) ;
+				delete c ;
+			}
+		}
+	}
+
+	node_t root ;
+	mutable epoch_domain epochs ;
+	std::mutex remove_lock ;
+} ;
+}
+
+#endif
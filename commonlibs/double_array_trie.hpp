@@ -0,0 +1,345 @@
+#ifndef __COMMONLIBS_DOUBLE_ARRAY_TRIE_HPP
+
+#define __COMMONLIBS_DOUBLE_ARRAY_TRIE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cctype>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "commonlibs/prefix_tree.hpp"
+#include "commonlibs/interproc/interp.hpp"
+
+namespace commonlibs {
+// one state of a double array: its base and the state it was reached from
+struct double_array_cell {
+	int32_t base ;
+	int32_t check ;  // parent state, free_check if the cell is unused
+	enum : int32_t { free_check = -1, root_check = -2 } ;
+	constexpr double_array_cell() : base(0), check(free_check) {}
+} ;
+
+// Lookups on double-array storage that lives anywhere: the vectors of a
+// double_array_trie or the mapped bytes of a trie file.  Holds pointers
+// only, never owns or writes the arrays.
+class double_array_view {
+public:
+	double_array_view(const double_array_cell *cells_, const int32_t *words_, const int32_t *prefixes_, std::size_t size_) {
+		cells = cells_ ;
+		words = words_ ;
+		prefixes = prefixes_ ;
+		ncells = size_ ;
+	}
+
+	// same results as Vertex::countWords on the frozen trie
+	int countWords(const char *p_word, size_t size) const {
+		if(p_word == NULL || size == 0) {
+			return words[0] ;
+		}
+		int32_t s = 0 ;
+		for(size_t k = 0 ; k < size ; ++ k) {
+			const int c = letter(p_word[k]) ;
+			if(c < 0) {
+				std::cerr << "only alphbets are allowed" << std::endl ;
+				return words[0] ;
+			}
+			s = next_state(s, c) ;
+			if(s < 0) {
+				return 0 ;
+			}
+		}
+		return words[s] ;
+	}
+
+	// same results as Vertex::countPrefixes on the frozen trie
+	int countPrefixes(const char *p_word, size_t size) const {
+		if(p_word == NULL || size == 0) {
+			return prefixes[0] ;
+		}
+		int32_t s = 0 ;
+		for(size_t k = 0 ; k < size ; ++ k) {
+			const int c = letter(p_word[k]) ;
+			if(c < 0) {
+				std::cerr << "only alphbets are allowed" << std::endl ;
+				return 0 ;
+			}
+			s = next_state(s, c) ;
+			if(s < 0) {
+				return 0 ;
+			}
+		}
+		return prefixes[s] ;
+	}
+
+	// state reached from s on letter c, or -1
+	int32_t next_state(int32_t s, int c) const {
+		const std::size_t t = (std::size_t) cells[s].base + c + 1 ;
+		return t < ncells && cells[t].check == s ? (int32_t) t : -1 ;
+	}
+
+	static int letter(char ch) {
+		if(! ::isalpha((unsigned char) ch)) {
+			return -1 ;
+		}
+		return ::tolower((unsigned char) ch) - 'a' ;
+	}
+
+private:
+	const double_array_cell *cells ;
+	const int32_t *words ;
+	const int32_t *prefixes ;
+	std::size_t ncells ;
+} ;
+
+// Read-only snapshot of a Vertex trie in double-array form (Aoe, 1989).
+//
+// State s moves on letter c to t = base[s] + c + 1, and the move exists iff
+// check[t] == s; base and check of a state share one 8-byte cell, so a step
+// is two reads with no pointer to chase.  words and prefixes keep the
+// Vertex counts per state and are only read once the walk is over.
+//
+// freeze() is the only way to fill one.  The result is never written
+// afterwards, so any number of threads may query it without locking.
+// countWords/countPrefixes answer exactly as on the Vertex it came from.
+// save() writes it to a file that mapped_double_array_trie maps in place.
+class double_array_trie {
+public:
+	enum { num_leaves = Vertex::num_leaves } ;
+
+	// an empty trie: every count is 0
+	double_array_trie() {
+		cells.assign(1, cell_t()) ;
+		cells[0].check = root_check ;
+		words.assign(1, 0) ;
+		prefixes.assign(1, 0) ;
+		nstates = 1 ;
+	}
+
+	// builds the double array of the trie under root in one breadth-first
+	// pass.  Each state takes the lowest base where all of its children
+	// land on free cells.
+	static double_array_trie freeze(const Vertex &root) {
+		double_array_trie t ;
+		std::vector<std::pair<const Vertex *, int32_t> > queue ;
+		queue.push_back(std::make_pair(&root, 0)) ;
+		t.words[0] = root.words ;
+		t.prefixes[0] = root.prefixes ;
+		std::size_t first_free = 1 ;
+		int children[num_leaves] ;
+		for(std::size_t head = 0 ; head < queue.size() ; ++ head) {
+			const Vertex *v = queue[head].first ;
+			const int32_t s = queue[head].second ;
+			int nc = 0 ;
+			for(int c = 0 ; c < num_leaves ; ++ c)
+				if(v->edges[c] != NULL)
+					children[nc ++] = c ;
+			if(nc == 0)
+				continue ;
+			// lowest base that puts every child on a free cell
+			std::size_t b = first_free > (std::size_t) children[0] + 1 ? first_free - children[0] - 1 : 0 ;
+			for(;; ++ b) {
+				t.reserve(b + children[nc - 1] + 2) ;
+				int k = 0 ;
+				while(k < nc && t.cells[b + children[k] + 1].check == free_check)
+					++ k ;
+				if(k == nc)
+					break ;
+			}
+			t.cells[s].base = (int32_t) b ;
+			for(int k = 0 ; k < nc ; ++ k) {
+				const int32_t next = (int32_t) (b + children[k] + 1) ;
+				const Vertex *child = v->edges[children[k]] ;
+				t.cells[next].check = s ;
+				t.words[next] = child->words ;
+				t.prefixes[next] = child->prefixes ;
+				queue.push_back(std::make_pair(child, next)) ;
+			}
+			t.nstates += nc ;
+			while(first_free < t.cells.size() && t.cells[first_free].check != free_check)
+				++ first_free ;
+		}
+		// drop the free tail left by the doubling in reserve()
+		std::size_t used = t.cells.size() ;
+		while(used > 1 && t.cells[used - 1].check == free_check)
+			-- used ;
+		t.cells.resize(used) ;
+		t.words.resize(used) ;
+		t.prefixes.resize(used) ;
+		t.cells.shrink_to_fit() ;
+		t.words.shrink_to_fit() ;
+		t.prefixes.shrink_to_fit() ;
+		return t ;
+	}
+
+	// same results as Vertex::countWords on the frozen trie
+	int countWords(const char *p_word, size_t size) const {
+		return view().countWords(p_word, size) ;
+	}
+
+	// same results as Vertex::countPrefixes on the frozen trie
+	int countPrefixes(const char *p_word, size_t size) const {
+		return view().countPrefixes(p_word, size) ;
+	}
+
+	double_array_view view() const {
+		return double_array_view(cells.data(), words.data(), prefixes.data(), cells.size()) ;
+	}
+
+	// writes the trie to a flat file that mapped_double_array_trie opens in
+	// place.  The file holds no pointers: a header, then the cells, words
+	// and prefixes arrays back to back, all in native byte order.  An
+	// existing file is replaced by renaming the new one over it, never
+	// truncated, so tries still mapping it keep their words.
+	// returns 0 on success, -1 on failure.
+	int save(const char *path) const {
+		const std::size_t n = cells.size() ;
+		named_mapped_file_server file(path, file_layout::bytes(n)) ;
+		if(file.open() != 0) {
+			return -1 ;
+		}
+		char *base = file.get_address() ;
+		std::memcpy(base + file_layout::cells_offset(), cells.data(), n * sizeof(cell_t)) ;
+		std::memcpy(base + file_layout::words_offset(n), words.data(), n * sizeof(int32_t)) ;
+		std::memcpy(base + file_layout::prefixes_offset(n), prefixes.data(), n * sizeof(int32_t)) ;
+		file_layout::header_t h ;
+		std::memset(&h, 0, sizeof(h)) ;
+		h.cells = n ;
+		h.states = nstates ;
+		std::memcpy(h.magic, file_layout::magic(), sizeof(h.magic)) ;
+		std::memcpy(base, &h, sizeof(h)) ;
+		return file.publish() ;
+	}
+
+	// number of trie nodes, root included
+	std::size_t state_count() const {
+		return nstates ;
+	}
+
+	// length of the base/check array; state_count() / array_size() is the
+	// fill ratio
+	std::size_t array_size() const {
+		return cells.size() ;
+	}
+
+	std::size_t bytes() const {
+		return cells.size() * (sizeof(cell_t) + 2 * sizeof(int32_t)) ;
+	}
+
+	// byte layout of a trie file; shared with mapped_double_array_trie
+	struct file_layout {
+		struct header_t {
+			char magic[8] ;
+			uint64_t cells ;
+			uint64_t states ;
+			uint64_t reserved ;
+		} ;
+		static const char * magic() { return "CTDATRI1" ; }
+		static std::size_t cells_offset() { return sizeof(header_t) ; }
+		static std::size_t words_offset(std::size_t n) { return cells_offset() + n * sizeof(double_array_cell) ; }
+		static std::size_t prefixes_offset(std::size_t n) { return words_offset(n) + n * sizeof(int32_t) ; }
+		static std::size_t bytes(std::size_t n) { return prefixes_offset(n) + n * sizeof(int32_t) ; }
+	} ;
+
+private:
+	typedef double_array_cell cell_t ;
+	enum : int32_t { free_check = cell_t::free_check, root_check = cell_t::root_check } ;
+
+	void reserve(std::size_t n) {
+		if(n > cells.size()) {
+			const std::size_t grown = n > 2 * cells.size() ? n : 2 * cells.size() ;
+			cells.resize(grown) ;
+			words.resize(grown, 0) ;
+			prefixes.resize(grown, 0) ;
+		}
+	}
+
+	std::vector<cell_t> cells ;
+	std::vector<int32_t> words ;
+	std::vector<int32_t> prefixes ;
+	std::size_t nstates ;
+} ;
+
+// A trie file written by double_array_trie::save, queried straight from a
+// read-only mapping: open() validates the header and nothing is copied or
+// rebuilt, so startup costs one mmap whatever the dictionary size.  The
+// mapping is shared, so processes that open the same file share its pages
+// in the page cache.  Immutable, like the double_array_trie it came from.
+class mapped_double_array_trie {
+public:
+	mapped_double_array_trie() : dav(&empty_cell, &zero, &zero, 1) {
+		nstates = 0 ;
+	}
+
+	mapped_double_array_trie(const mapped_double_array_trie &) = delete ;
+	mapped_double_array_trie & operator=(const mapped_double_array_trie &) = delete ;
+
+	// maps the file at path.  returns 0 on success, -1 if it is missing or
+	// is not a trie file.
+	int open(const char *path_) {
+		close() ;
+		path = path_ ;
+		file.reset(new named_mapped_file_client(path.c_str())) ;
+		if(file->open() != 0) {
+			close() ;
+			return -1 ;
+		}
+		typedef double_array_trie::file_layout layout ;
+		const char *base = file->get_address() ;
+		layout::header_t h ;
+		if(file->get_size() >= sizeof(h))
+			std::memcpy(&h, base, sizeof(h)) ;
+		if(file->get_size() < sizeof(h)
+			|| std::memcmp(h.magic, layout::magic(), sizeof(h.magic)) != 0
+			|| h.cells == 0 || h.cells > (uint64_t) INT32_MAX
+			|| file->get_size() != layout::bytes(h.cells)) {
+			std::cerr << "Error, " << path << " is not a trie file" << std::endl ;
+			close() ;
+			return -1 ;
+		}
+		dav = double_array_view((const double_array_cell *) (base + layout::cells_offset()),
+			(const int32_t *) (base + layout::words_offset(h.cells)),
+			(const int32_t *) (base + layout::prefixes_offset(h.cells)), h.cells) ;
+		nstates = h.states ;
+		return 0 ;
+	}
+
+	void close() {
+		dav = double_array_view(&empty_cell, &zero, &zero, 1) ;
+		file.reset() ;
+		nstates = 0 ;
+	}
+
+	bool is_open() const {
+		return file != NULL ;
+	}
+
+	// 0 while nothing is open
+	int countWords(const char *p_word, size_t size) const {
+		return dav.countWords(p_word, size) ;
+	}
+
+	int countPrefixes(const char *p_word, size_t size) const {
+		return dav.countPrefixes(p_word, size) ;
+	}
+
+	std::size_t state_count() const {
+		return nstates ;
+	}
+
+private:
+	static constexpr double_array_cell empty_cell = double_array_cell() ;
+	static constexpr int32_t zero = 0 ;
+
+	std::string path ;
+	std::unique_ptr<named_mapped_file_client> file ;
+	double_array_view dav ;
+	std::size_t nstates ;
+} ;
+}
+
+#endif
@@ -10,6 +10,7 @@
 #include <stdexcept>
 #include <cerrno>
 #include <cstring>
+#include <string>
 
 enum objecttype {
 	IP_SHARED_MEM = 0xF010000,
@@ -23,18 +24,25 @@ enum creationType {
 ///\brief created a named shared memory object.
 ///\param name_p : INPUT, the name of the shared objects
 ///\param size : INPUT, the size of the shared mem object.
+/// With IP_MEM_MAPPED_FILE the name is a file path and the client maps an
+/// existing file read only.  The server writes a new file, name + ".tmp",
+/// at the given size, and publish() renames it over the name once it is
+/// complete, so processes mapping the old file keep it intact.  A published
+/// file is kept after the object is destroyed; an unpublished one is removed.
 ///return value: 0, success;
 ///return -1 : failed because of inter process exception
 template  <typename PointerType, enum objecttype  ObjType, enum creationType CType=IP_SERVERMODE>
 class named_shared_object{
 private:
-	char *cstr_name ;
+	const char *cstr_name ;
 	std::size_t u_memsize ;
 	PointerType p_mem ;
 	int fd_ ;
 	void* mapped_addr_ ;
+	std::string tmp_name_ ;
+	bool published_ ;
 public:
-	named_shared_object (char *name_p, unsigned int size = 0) {
+	named_shared_object (const char *name_p, std::size_t size = 0) {
 		cstr_name = NULL ;
 		cstr_name = name_p ;
 		u_memsize = size ;
@@ -42,8 +50,9 @@ public:
 		p_mem = static_cast<PointerType>(NULL) ;
 		fd_ = -1 ;
 		mapped_addr_ = MAP_FAILED ;
+		published_ = false ;
 		//Erase previous shared memory
-		if(CType == IP_SERVERMODE)
+		if(CType == IP_SERVERMODE && ObjType == IP_SHARED_MEM)
 			shm_unlink(name_p);
 	}
 	int open ()
@@ -51,14 +60,19 @@ public:
 		try{
 			if(CType == IP_CLIENTMODE)
 			{
-				fd_ = shm_open(cstr_name, O_RDONLY, 0);
+				if(ObjType == IP_MEM_MAPPED_FILE)
+					fd_ = ::open(cstr_name, O_RDONLY);
+				else
+					fd_ = shm_open(cstr_name, O_RDONLY, 0);
 				if(fd_ == -1)
-					throw std::runtime_error(std::string("shm_open(read_only) failed: ") + std::strerror(errno));
+					throw std::runtime_error(std::string("open(read_only) failed: ") + std::strerror(errno));
 
 				struct stat sb;
 				if(fstat(fd_, &sb) == -1)
 					throw std::runtime_error(std::string("fstat failed: ") + std::strerror(errno));
 				u_memsize = static_cast<std::size_t>(sb.st_size);
+				if(u_memsize == 0)
+					throw std::runtime_error("mmap(read_only) failed: object is empty");
 
 				mapped_addr_ = mmap(nullptr, u_memsize, PROT_READ, MAP_SHARED, fd_, 0);
 				if(mapped_addr_ == MAP_FAILED)
@@ -73,9 +87,14 @@ public:
 					std::cerr << "Size invalid" << std::endl ;
 					return -1 ;
 				}
-				fd_ = shm_open(cstr_name, O_CREAT | O_RDWR, 0666);
+				if(ObjType == IP_MEM_MAPPED_FILE) {
+					tmp_name_ = std::string(cstr_name) + ".tmp";
+					fd_ = ::open(tmp_name_.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0666);
+				}
+				else
+					fd_ = shm_open(cstr_name, O_CREAT | O_RDWR, 0666);
 				if(fd_ == -1)
-					throw std::runtime_error(std::string("shm_open(create) failed: ") + std::strerror(errno));
+					throw std::runtime_error(std::string("open(create) failed: ") + std::strerror(errno));
 
 				if(ftruncate(fd_, static_cast<off_t>(u_memsize)) == -1)
 					throw std::runtime_error(std::string("ftruncate failed: ") + std::strerror(errno));
@@ -85,12 +104,16 @@ public:
 					throw std::runtime_error(std::string("mmap(read_write) failed: ") + std::strerror(errno));
 
 				p_mem = static_cast<PointerType>(mapped_addr_);
-				std::memset(mapped_addr_, 0, u_memsize);
+				// a freshly truncated file already reads as zeros; touching
+				// every page here would defeat mapping files larger than RAM
+				if(ObjType == IP_SHARED_MEM)
+					std::memset(mapped_addr_, 0, u_memsize);
 			}
 		}
 		catch(const std::runtime_error &ex){
 			if(fd_ != -1) { ::close(fd_); fd_ = -1; }
-			if(CType == IP_SERVERMODE) shm_unlink(cstr_name);
+			if(CType == IP_SERVERMODE && ObjType == IP_SHARED_MEM) shm_unlink(cstr_name);
+			if(!tmp_name_.empty()) { ::unlink(tmp_name_.c_str()); tmp_name_.clear(); }
 			std::cerr << ex.what() << std::endl;
 			return -1;
 		}
@@ -98,6 +121,23 @@ public:
 
 	}
 
+	///\brief IP_MEM_MAPPED_FILE server: flushes the file and renames it
+	/// over the name.  return 0 on success, -1 on failure.
+	int publish ()
+	{
+		if(tmp_name_.empty() || published_) {
+			std::cerr << "Error, nothing to publish" << std::endl ;
+			return -1 ;
+		}
+		if(msync(mapped_addr_, u_memsize, MS_SYNC) == -1
+			|| ::rename(tmp_name_.c_str(), cstr_name) == -1) {
+			std::cerr << "Error, cannot publish " << cstr_name << ": " << std::strerror(errno) << std::endl ;
+			return -1 ;
+		}
+		published_ = true ;
+		return 0 ;
+	}
+
 	PointerType get_address() const
 	{
 		return p_mem ;
@@ -111,7 +151,9 @@ public:
 			munmap(mapped_addr_, u_memsize);
 		if(fd_ != -1)
 			::close(fd_);
-		if(cstr_name != NULL && CType == IP_SERVERMODE) {
+		if(!tmp_name_.empty() && !published_)
+			::unlink(tmp_name_.c_str());
+		if(cstr_name != NULL && CType == IP_SERVERMODE && ObjType == IP_SHARED_MEM) {
 			shm_unlink(cstr_name);
 			std::cout << "destructed" << std::endl ;
 		}
@@ -123,5 +165,9 @@ typedef named_shared_object<char * , IP_SHARED_MEM , IP_SERVERMODE> named_shared
 
 typedef named_shared_object<const char * , IP_SHARED_MEM , IP_CLIENTMODE> named_shared_mem_client ;
 
+typedef named_shared_object<char * , IP_MEM_MAPPED_FILE , IP_SERVERMODE> named_mapped_file_server ;
+
+typedef named_shared_object<const char * , IP_MEM_MAPPED_FILE , IP_CLIENTMODE> named_mapped_file_client ;
+
 
 #endif
@@ -0,0 +1,311 @@
+#ifndef __COMMONLIBS_LOUDS_TRIE_HPP
+
+#define __COMMONLIBS_LOUDS_TRIE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cctype>
+#include <iostream>
+#include <vector>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#include "commonlibs/prefix_tree.hpp"
+
+namespace commonlibs {
+// Bit vector with rank and select in O(1) word operations.
+//
+// Bits are packed 64 to a word.  After build(), a directory holds the
+// number of ones before each 512-bit block, so rank is one directory read
+// plus popcounts of at most 8 words.  Select starts from a sample taken
+// every 512 ones (or zeros), binary searches the blocks up to the next
+// sample, then scans at most 8 words and selects inside the last one.
+// The index costs about a quarter of the bits it covers.
+class rank_select_bitvector {
+public:
+	rank_select_bitvector() : nbits(0), nones(0) {}
+
+	void push_back(bool bit) {
+		if(nbits % 64 == 0)
+			words.push_back(0) ;
+		if(bit)
+			words.back() |= (uint64_t) 1 << (nbits % 64) ;
+		++ nbits ;
+	}
+
+	// indexes the bits pushed so far; rank and select need it
+	void build() {
+		const std::size_t nblocks = words.size() / block_words + 1 ;
+		blocks.assign(nblocks + 1, 0) ;
+		samples1.clear() ;
+		samples0.clear() ;
+		uint64_t ones = 0 ;
+		for(std::size_t b = 0 ; b < nblocks ; ++ b) {
+			blocks[b] = ones ;
+			for(std::size_t w = b * block_words ; w < (b + 1) * block_words && w < words.size() ; ++ w)
+				ones += __builtin_popcountll(words[w]) ;
+		}
+		blocks[nblocks] = ones ;
+		nones = ones ;
+		// samples[j]: block holding the (j * sample_rate)-th one (zero)
+		for(std::size_t b = 0 ; b < nblocks ; ++ b) {
+			while(samples1.size() * sample_rate < blocks[b + 1])
+				samples1.push_back(b) ;
+			while(samples0.size() * sample_rate < zeros_before(b + 1))
+				samples0.push_back(b) ;
+		}
+		samples1.push_back(nblocks - 1) ;
+		samples0.push_back(nblocks - 1) ;
+	}
+
+	bool operator[](std::size_t i) const {
+		return (words[i / 64] >> (i % 64)) & 1 ;
+	}
+
+	// number of ones in [0, i)
+	std::size_t rank1(std::size_t i) const {
+		const std::size_t b = i / block_bits ;
+		std::size_t r = blocks[b] ;
+		for(std::size_t w = b * block_words ; w < i / 64 ; ++ w)
+			r += __builtin_popcountll(words[w]) ;
+		if(i % 64 != 0)
+			r += __builtin_popcountll(words[i / 64] & (((uint64_t) 1 << (i % 64)) - 1)) ;
+		return r ;
+	}
+
+	// number of zeros in [0, i)
+	std::size_t rank0(std::size_t i) const {
+		return i - rank1(i) ;
+	}
+
+	// position of the k-th one, counting from 0; size() if there is none
+	std::size_t select1(std::size_t k) const {
+		return select<true>(k) ;
+	}
+
+	// position of the k-th zero, counting from 0; size() if there is none
+	std::size_t select0(std::size_t k) const {
+		return select<false>(k) ;
+	}
+
+	// position of the first zero at or after i; size() if there is none
+	std::size_t next_zero(std::size_t i) const {
+		for(std::size_t w = i / 64 ; w < words.size() ; ++ w) {
+			uint64_t x = ~words[w] ;
+			if(w == i / 64)
+				x &= ~(uint64_t) 0 << (i % 64) ;
+			if(x != 0) {
+				const std::size_t p = w * 64 + __builtin_ctzll(x) ;
+				return p < nbits ? p : nbits ;
+			}
+		}
+		return nbits ;
+	}
+
+	std::size_t size() const {
+		return nbits ;
+	}
+
+	std::size_t ones() const {
+		return nones ;
+	}
+
+	std::size_t bytes() const {
+		return (words.size() + blocks.size() + samples1.size() + samples0.size()) * sizeof(uint64_t) ;
+	}
+
+private:
+	enum { block_words = 8, block_bits = 512, sample_rate = 512 } ;
+
+	std::size_t zeros_before(std::size_t b) const {
+		const std::size_t bits = b * block_bits < nbits ? b * block_bits : nbits ;
+		return bits - blocks[b] ;
+	}
+
+	template <bool One>
+	std::size_t count_before(std::size_t b) const {
+		return One ? blocks[b] : b * block_bits - blocks[b] ;
+	}
+
+	template <bool One>
+	std::size_t select(std::size_t k) const {
+		if(k >= (One ? nones : nbits - nones)) {
+			return nbits ;
+		}
+		const std::vector<uint64_t> &samples = One ? samples1 : samples0 ;
+		// last block in [lo, hi] that starts with at most k of them
+		std::size_t lo = samples[k / sample_rate], hi = samples[k / sample_rate + 1] ;
+		while(lo < hi) {
+			const std::size_t mid = (lo + hi + 1) / 2 ;
+			if(count_before<One>(mid) <= k)
+				lo = mid ;
+			else
+				hi = mid - 1 ;
+		}
+		k -= count_before<One>(lo) ;
+		for(std::size_t w = lo * block_words ; ; ++ w) {
+			const uint64_t x = One ? words[w] : ~words[w] ;
+			const std::size_t c = __builtin_popcountll(x) ;
+			if(k < c)
+				return w * 64 + select_in_word(x, (unsigned) k) ;
+			k -= c ;
+		}
+	}
+
+	// position of the k-th set bit of x, k < popcount(x)
+	static unsigned select_in_word(uint64_t x, unsigned k) {
+#if defined(__BMI2__)
+		return __builtin_ctzll(_pdep_u64((uint64_t) 1 << k, x)) ;
+#else
+		unsigned shift = 0 ;
+		for(;; shift += 8) {
+			const unsigned c = __builtin_popcountll((x >> shift) & 0xff) ;
+			if(k < c)
+				break ;
+			k -= c ;
+		}
+		uint64_t b = (x >> shift) & 0xff ;
+		for( ; k > 0 ; -- k)
+			b &= b - 1 ;
+		return shift + __builtin_ctzll(b) ;
+#endif
+	}
+
+	std::vector<uint64_t> words ;
+	std::vector<uint64_t> blocks ;    // ones before each block, plus the total
+	std::vector<uint64_t> samples1 ;  // one extra entry closes the last range
+	std::vector<uint64_t> samples0 ;
+	std::size_t nbits ;
+	std::size_t nones ;
+} ;
+
+// Read-only succinct snapshot of a Vertex trie in LOUDS form (Jacobson,
+// 1989): about 2 bits of shape and one label byte per node, instead of a
+// 216-byte Vertex.
+//
+// Nodes are numbered breadth first, root 0.  The shape is "10" followed,
+// for every node in order, by a 1 per child and a 0.  Node i is the i-th
+// 1, so its children are the run of ones after the i-th 0: they start at
+// p = select0(i) + 1, their ids at p - i - 1, and the run ends at the next
+// 0.  labels[id - 1] is the letter into node id; children are in letter
+// order.  A second bit vector marks the nodes that end a word, and its
+// rank gives the slot of the word count.
+//
+// freeze() is the only way to fill one.  countWords/countPrefixes answer
+// exactly as on the Vertex it came from, and are safe from any number of
+// threads.
+class louds_trie {
+public:
+	// an empty trie: every count is 0
+	louds_trie() {
+		shape.push_back(true) ;
+		shape.push_back(false) ;
+		shape.push_back(false) ;
+		shape.build() ;
+		terminal.push_back(false) ;
+		terminal.build() ;
+	}
+
+	static louds_trie freeze(const Vertex &root) {
+		louds_trie t ;
+		t.shape = rank_select_bitvector() ;
+		t.terminal = rank_select_bitvector() ;
+		t.shape.push_back(true) ;
+		t.shape.push_back(false) ;
+		std::vector<const Vertex *> queue(1, &root) ;
+		for(std::size_t head = 0 ; head < queue.size() ; ++ head) {
+			const Vertex *v = queue[head] ;
+			for(int c = 0 ; c < Vertex::num_leaves ; ++ c) {
+				if(v->edges[c] != NULL) {
+					t.shape.push_back(true) ;
+					t.labels.push_back((uint8_t) c) ;
+					queue.push_back(v->edges[c]) ;
+				}
+			}
+			t.shape.push_back(false) ;
+			t.terminal.push_back(v->words > 0) ;
+			if(v->words > 0)
+				t.counts.push_back(v->words) ;
+		}
+		t.shape.build() ;
+		t.terminal.build() ;
+		t.labels.shrink_to_fit() ;
+		t.counts.shrink_to_fit() ;
+		return t ;
+	}
+
+	// same results as Vertex::countWords on the frozen trie
+	int countWords(const char *p_word, size_t size) const {
+		const int root_words = words_at(0) ;
+		if(p_word == NULL || size == 0) {
+			return root_words ;
+		}
+		std::size_t node = 0 ;
+		for(size_t k = 0 ; k < size ; ++ k) {
+			if(! ::isalpha((unsigned char) p_word[k])) {
+				std::cerr << "only alphbets are allowed" << std::endl ;
+				return root_words ;
+			}
+			node = child(node, ::tolower((unsigned char) p_word[k]) - 'a') ;
+			if(node == npos) {
+				return 0 ;
+			}
+		}
+		return words_at(node) ;
+	}
+
+	// same results as Vertex::countPrefixes on the frozen trie
+	int countPrefixes(const char *p_word, size_t size) const {
+		std::size_t node = 0 ;
+		for(size_t k = 0 ; p_word != NULL && k < size ; ++ k) {
+			if(! ::isalpha((unsigned char) p_word[k])) {
+				std::cerr << "only alphbets are allowed" << std::endl ;
+				return 0 ;
+			}
+			node = child(node, ::tolower((unsigned char) p_word[k]) - 'a') ;
+			if(node == npos) {
+				return 0 ;
+			}
+		}
+		const std::size_t p = shape.select0(node) + 1 ;
+		return (int) (shape.next_zero(p) - p) ;
+	}
+
+	// number of trie nodes, root included
+	std::size_t node_count() const {
+		return labels.size() + 1 ;
+	}
+
+	std::size_t bytes() const {
+		return shape.bytes() + terminal.bytes() + labels.size() + counts.size() * sizeof(int32_t) ;
+	}
+
+private:
+	static const std::size_t npos = (std::size_t) -1 ;
+
+	// child of node on letter c, or npos
+	std::size_t child(std::size_t node, int c) const {
+		const std::size_t p = shape.select0(node) + 1 ;
+		const std::size_t first = p - node - 1 ;
+		for(std::size_t q = p ; shape[q] ; ++ q) {
+			const int l = labels[first + (q - p) - 1] ;
+			if(l >= c)
+				return l == c ? first + (q - p) : npos ;
+		}
+		return npos ;
+	}
+
+	int words_at(std::size_t node) const {
+		return terminal[node] ? counts[terminal.rank1(node)] : 0 ;
+	}
+
+	rank_select_bitvector shape ;
+	rank_select_bitvector terminal ;  // node ends a word
+	std::vector<uint8_t> labels ;     // letter into node id, at id - 1
+	std::vector<int32_t> counts ;     // word counts of the terminal nodes
+} ;
+}
+
+#endif
@@ -0,0 +1,247 @@
+#ifndef __COMMONLIBS_MAPPED_SEGMENT_TREE_HPP
+
+#define __COMMONLIBS_MAPPED_SEGMENT_TREE_HPP
+
+#include <iostream>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "commonlibs/interproc/interp.hpp"
+#include "commonlibs/wide_segment_tree.hpp"
+
+namespace commonlibs {
+// Out-of-core range minimum: the B-ary tree of wide_segments_tree stored in
+// a file and used straight from a read-only mmap, for arrays that do not
+// fit in memory beside the rest of the process.
+//
+// build() writes the tree once; open() maps it in O(1) and later queries
+// fault in only the pages they read.  The file is a 4 KB header followed by
+// the levels top down, each level a run of B-key blocks (one cache line for
+// B = 8).  The few upper levels share the first pages and stay resident, and
+// a query reads at most two blocks per level, so a cold query costs about
+// 2 * log_B(n) page faults and a warm one the same number of cache lines.
+//
+// The file is native endian and holds up to 2^32 - 2 elements; query
+// returns the index of the leftmost minimum, or -1.
+template <int B = 8>
+class mapped_segments_tree {
+	typedef wide_block_ops<B> ops ;
+public:
+	typedef long long key_t ;
+
+	mapped_segments_tree() {
+		hdr = NULL ;
+		data = NULL ;
+	}
+
+	mapped_segments_tree(const mapped_segments_tree &) = delete ;
+	mapped_segments_tree & operator=(const mapped_segments_tree &) = delete ;
+
+	// writes the tree for A[0 .. n) to the file at path, replacing it.  The
+	// tree is written beside it and renamed over it when complete, so trees
+	// open on the old file keep working.  A is read once, front to back, so
+	// it may itself be a mapping of a file.  returns 0 on success, -1 on
+	// failure.
+	static int build(const char *path, const int *A, long long n) {
+		if(A == NULL || n <= 0 || n > max_elements) {
+			std::cerr << "Error, cannot build a mapped tree of " << n << " elements" << std::endl ;
+			return -1 ;
+		}
+		header_t h ;
+		std::memset(&h, 0, sizeof(h)) ;
+		h.block_keys = B ;
+		h.array_size = (uint64_t) n ;
+		std::vector<uint64_t> nblocks = level_blocks(h.array_size) ;
+		h.height = (uint32_t) nblocks.size() ;
+		const uint64_t off = lay_out(nblocks, h.level_offset) ;
+		h.total_blocks = off ;
+
+		named_mapped_file_server file(path, header_bytes + (std::size_t) off * B * sizeof(key_t)) ;
+		if(file.open() != 0) {
+			return -1 ;
+		}
+		key_t *keys = (key_t *) (file.get_address() + header_bytes) ;
+		key_t *level0 = keys + h.level_offset[0] * B ;
+		for(uint64_t k = 0 ; k < nblocks[0] * B ; ++ k) {
+			level0[k] = k < (uint64_t) n ? ops::make_key(A[k], (unsigned int) k) : ops::empty_key() ;
+		}
+		for(uint32_t lv = 1 ; lv < h.height ; ++ lv) {
+			const key_t *below = keys + h.level_offset[lv - 1] * B ;
+			key_t *dst = keys + h.level_offset[lv] * B ;
+			for(uint64_t e = 0 ; e < nblocks[lv] * B ; ++ e) {
+				dst[e] = e < nblocks[lv - 1] ? ops::block_min(below + e * B, 0, B - 1) : ops::empty_key() ;
+			}
+		}
+		std::memcpy(h.magic, file_magic, sizeof(h.magic)) ;
+		std::memcpy(file.get_address(), &h, sizeof(h)) ;
+		return file.publish() ;
+	}
+
+	// maps a file written by build().  returns 0 on success, -1 if the file
+	// is missing or is not a tree built with the same B.  The whole header
+	// is checked against the layout build() gives its array size, so a
+	// damaged file cannot send a query outside the mapping.
+	int open(const char *path_) {
+		close() ;
+		path = path_ ;
+		file.reset(new named_mapped_file_client(path.c_str())) ;
+		if(file->open() != 0) {
+			close() ;
+			return -1 ;
+		}
+		const header_t *h = (const header_t *) file->get_address() ;
+		if(file->get_size() < header_bytes
+			|| std::memcmp(h->magic, file_magic, sizeof(h->magic)) != 0
+			|| h->block_keys != (uint32_t) B
+			|| ! valid_layout(*h, file->get_size())) {
+			std::cerr << "Error, " << path << " is not a mapped segment tree with B = " << B << std::endl ;
+			close() ;
+			return -1 ;
+		}
+		hdr = h ;
+		data = (const key_t *) (file->get_address() + header_bytes) ;
+		return 0 ;
+	}
+
+	void close() {
+		file.reset() ;
+		hdr = NULL ;
+		data = NULL ;
+	}
+
+	bool is_open() const {
+		return hdr != NULL ;
+	}
+
+	// returns the index of the minimum in [i, j] (the leftmost one on ties),
+	// or -1 if the range does not overlap the array or nothing is open.
+	long long query(long long i, long long j) const {
+		if(hdr == NULL) {
+			return -1 ;
+		}
+		if(i < 0) i = 0 ;
+		if(j >= size()) j = size() - 1 ;
+		if(i > j) {
+			return -1 ;
+		}
+		key_t best = ops::empty_key() ;
+		uint64_t l = i, r = j ;
+		for(uint32_t lv = 0 ; lv < hdr->height ; ++ lv) {
+			const key_t *base = data + hdr->level_offset[lv] * B ;
+			const uint64_t bl = l / B, br = r / B ;
+			if(bl == br) {
+				key_t m = ops::block_min(base + bl * B, l % B, r % B) ;
+				best = m < best ? m : best ;
+				break ;
+			}
+			// a block covered completely is handled one level up
+			if(l % B != 0) {
+				key_t m = ops::block_min(base + bl * B, l % B, B - 1) ;
+				best = m < best ? m : best ;
+				l = bl + 1 ;
+			}
+			else {
+				l = bl ;
+			}
+			if(r % B != B - 1) {
+				key_t m = ops::block_min(base + br * B, 0, r % B) ;
+				best = m < best ? m : best ;
+				r = br - 1 ;
+			}
+			else {
+				r = br ;
+			}
+			if(l > r)
+				break ;
+		}
+		return (long long) ops::key_index(best) ;
+	}
+
+	// value of element i; INT_MAX if i is out of range or nothing is open
+	int value(long long i) const {
+		if(hdr == NULL || i < 0 || i >= size()) {
+			return INT_MAX ;
+		}
+		return ops::key_value(data[hdr->level_offset[0] * B + i]) ;
+	}
+
+	long long size() const {
+		return hdr == NULL ? 0 : (long long) hdr->array_size ;
+	}
+
+	int levels() const {
+		return hdr == NULL ? 0 : (int) hdr->height ;
+	}
+
+private:
+	enum { max_levels = 32 } ;
+	static constexpr std::size_t header_bytes = 4096 ;
+	static constexpr long long max_elements = 0xfffffffeLL ;
+	static constexpr const char *file_magic = "CTMSEGT1" ;
+
+	struct header_t {
+		char magic[8] ;
+		uint32_t block_keys ;
+		uint32_t height ;
+		uint64_t array_size ;
+		uint64_t total_blocks ;
+		uint64_t level_offset[max_levels] ; // first block of each level
+	} ;
+
+	// level sizes in blocks, bottom up, until one block covers everything
+	static std::vector<uint64_t> level_blocks(uint64_t n) {
+		std::vector<uint64_t> nblocks ;
+		uint64_t entries = n ;
+		for(;;) {
+			nblocks.push_back((entries + B - 1) / B) ;
+			if(nblocks.back() <= 1)
+				break ;
+			entries = nblocks.back() ;
+		}
+		return nblocks ;
+	}
+
+	// lays the levels out top down, the root block first; returns the
+	// total number of blocks
+	static uint64_t lay_out(const std::vector<uint64_t> &nblocks, uint64_t *level_offset) {
+		uint64_t off = 0 ;
+		for(int lv = (int) nblocks.size() - 1 ; lv >= 0 ; -- lv) {
+			level_offset[lv] = off ;
+			off += nblocks[lv] ;
+		}
+		return off ;
+	}
+
+	// true if h is the header build() writes for its array size, in a file
+	// of file_size bytes
+	static bool valid_layout(const header_t &h, std::size_t file_size) {
+		if(h.array_size == 0 || h.array_size > (uint64_t) max_elements)
+			return false ;
+		const std::vector<uint64_t> nblocks = level_blocks(h.array_size) ;
+		if(h.height != nblocks.size() || h.height > max_levels)
+			return false ;
+		uint64_t offsets[max_levels] ;
+		if(lay_out(nblocks, offsets) != h.total_blocks)
+			return false ;
+		for(uint32_t lv = 0 ; lv < h.height ; ++ lv)
+			if(h.level_offset[lv] != offsets[lv])
+				return false ;
+		// total_blocks is bounded by the array size, but keep the product honest
+		if(h.total_blocks > (SIZE_MAX - header_bytes) / (B * sizeof(key_t)))
+			return false ;
+		return file_size == header_bytes + h.total_blocks * B * sizeof(key_t) ;
+	}
+	static_assert(sizeof(header_t) <= header_bytes, "header does not fit its page") ;
+
+	std::string path ;
+	std::unique_ptr<named_mapped_file_client> file ;
+	const header_t *hdr ;
+	const key_t *data ;
+} ;
+}
+
+#endif
@@ -0,0 +1,241 @@
+#ifndef __COMMONLIBS_PERSISTENT_SEGMENT_TREE_HPP
+
+#define __COMMONLIBS_PERSISTENT_SEGMENT_TREE_HPP
+
+#include <iostream>
+#include <climits>
+#include <vector>
+
+#include "commonlibs/arena.hpp"
+
+namespace commonlibs {
+// persistent (versioned) range minimum tree.
+//
+// initialize() builds version 0 from A; every update(i, value) copies the
+// O(log n) nodes on the path to leaf i and becomes the next version, so
+// any retained version can be queried in O(log n): "what was the range
+// minimum as of update k".  Nodes come from a chunk_arena and refer to
+// their children by 32-bit handles.  drop_versions_before(k) copies the
+// nodes still reachable from versions >= k into a fresh arena and releases
+// every old chunk in one go.  It cannot free old chunks without the copy:
+// every version shares the untouched nodes of version 0, which sit in the
+// oldest chunks.  So a drop costs time in the nodes kept, and memory
+// for the old arena, the copy and 4 bytes per old node at its peak; drop
+// many versions at a time rather than one per update.
+//
+// query(version, i, j) returns the index of the leftmost minimum like
+// segments_tree::query, with the version in place of the node argument.
+class persistent_segments_tree {
+	struct node_t {
+		int value ;     // minimum of the node's range
+		int index ;     // leftmost position of that minimum
+		uint32_t left ;
+		uint32_t right ;
+	} ;
+	typedef chunk_arena<node_t> arena_t ;
+
+public:
+	typedef arena_t::handle_t handle_t ;
+
+	persistent_segments_tree(const int *A_, int arraysize_) {
+		A = A_ ;
+		array_size = arraysize_ > 0 ? arraysize_ : 0 ;
+		first_version = 0 ;
+	}
+
+	// builds version 0 from A and forgets any previous history.
+	// node/begin/end are ignored as in segments_tree::initialize.
+	void initialize(int node = 0, int begin = 0, int end = -1) {
+		(void) node ; (void) begin ; (void) end ;
+		nodes.clear() ;
+		roots.clear() ;
+		first_version = 0 ;
+		if(array_size == 0 || A == NULL) {
+			return ;
+		}
+		roots.push_back(build_imp(0, array_size - 1)) ;
+	}
+
+	// sets element i to value in a new version, O(log n) new nodes.
+	// returns the new version number, or -1 if i is out of range.
+	int update(int i, int value) {
+		if(i < 0 || i >= array_size || roots.empty()) {
+			std::cerr << "Error, update index " << i << " out of range [0, " << array_size << ")" << std::endl ;
+			return -1 ;
+		}
+		roots.push_back(update_imp(roots.back(), 0, array_size - 1, i, value)) ;
+		return latest_version() ;
+	}
+
+	// index of the minimum of [i, j] in the given version (leftmost on
+	// ties); -1 if the range does not overlap the array or the version is
+	// not retained.
+	int query(int version, int i, int j) const {
+		if(!has_version(version)) {
+			return -1 ;
+		}
+		if(i < 0) i = 0 ;
+		if(j >= array_size) j = array_size - 1 ;
+		if(i > j) {
+			return -1 ;
+		}
+		return query_imp(roots[version - first_version], 0, array_size - 1, i, j).index ;
+	}
+
+	// value of element i in the given version; INT_MAX if not available
+	int value(int version, int i) const {
+		if(!has_version(version) || i < 0 || i >= array_size) {
+			return INT_MAX ;
+		}
+		return query_imp(roots[version - first_version], 0, array_size - 1, i, i).value ;
+	}
+
+	// discards versions older than version, compacting the arena in
+	// O(nodes reachable from the versions kept).
+	// returns 0 on success, -1 if version is not retained.
+	int drop_versions_before(int version) {
+		if(!has_version(version)) {
+			std::cerr << "Error, version " << version << " is not retained" << std::endl ;
+			return -1 ;
+		}
+		if(version == first_version) {
+			return 0 ;
+		}
+		arena_t fresh ;
+		std::vector<handle_t> forward(nodes.size(), null_node) ;
+		std::vector<handle_t> kept ;
+		kept.reserve(roots.size() - (version - first_version)) ;
+		for(std::size_t v = version - first_version ; v < roots.size() ; ++ v) {
+			kept.push_back(copy_imp(roots[v], fresh, forward)) ;
+		}
+		nodes.swap(fresh) ;
+		roots.swap(kept) ;
+		first_version = version ;
+		return 0 ;
+	}
+
+	bool has_version(int version) const {
+		return version >= first_version && version - first_version < (int) roots.size() ;
+	}
+
+	int latest_version() const {
+		return first_version + (int) roots.size() - 1 ;
+	}
+
+	int oldest_version() const {
+		return first_version ;
+	}
+
+	int size() const {
+		return array_size ;
+	}
+
+	// nodes currently held by the arena
+	std::size_t node_count() const {
+		return nodes.size() ;
+	}
+
+	std::size_t bytes_reserved() const {
+		return nodes.bytes_reserved() ;
+	}
+
+private:
+	static constexpr handle_t null_node = arena_t::null_handle ;
+
+	struct min_t {
+		int value ;
+		int index ;
+	} ;
+
+	static min_t min_of(const min_t &a, const min_t &b) {
+		if(a.value < b.value || (a.value == b.value && a.index < b.index))
+			return a ;
+		return b ;
+	}
+
+	handle_t make_node(int value, int index, handle_t left, handle_t right) {
+		handle_t h = nodes.allocate() ;
+		node_t &n = nodes[h] ;
+		n.value = value ;
+		n.index = index ;
+		n.left = left ;
+		n.right = right ;
+		return h ;
+	}
+
+	handle_t join(handle_t left, handle_t right) {
+		const node_t &l = nodes[left] ;
+		const node_t &r = nodes[right] ;
+		if(r.value < l.value)
+			return make_node(r.value, r.index, left, right) ;
+		return make_node(l.value, l.index, left, right) ;
+	}
+
+	handle_t build_imp(int begin, int end) {
+		if(begin == end) {
+			return make_node(A[begin], begin, null_node, null_node) ;
+		}
+		int mid = (begin + end) / 2 ;
+		handle_t l = build_imp(begin, mid) ;
+		handle_t r = build_imp(mid + 1, end) ;
+		return join(l, r) ;
+	}
+
+	handle_t update_imp(handle_t node, int begin, int end, int i, int value) {
+		if(begin == end) {
+			return make_node(value, begin, null_node, null_node) ;
+		}
+		int mid = (begin + end) / 2 ;
+		handle_t l = nodes[node].left ;
+		handle_t r = nodes[node].right ;
+		if(i <= mid)
+			l = update_imp(l, begin, mid, i, value) ;
+		else
+			r = update_imp(r, mid + 1, end, i, value) ;
+		return join(l, r) ;
+	}
+
+	min_t query_imp(handle_t node, int begin, int end, int i, int j) const {
+		const node_t &n = nodes[node] ;
+		if(begin >= i && end <= j) {
+			min_t m = { n.value, n.index } ;
+			return m ;
+		}
+		int mid = (begin + end) / 2 ;
+		if(j <= mid)
+			return query_imp(n.left, begin, mid, i, j) ;
+		if(i > mid)
+			return query_imp(n.right, mid + 1, end, i, j) ;
+		return min_of(query_imp(n.left, begin, mid, i, j), query_imp(n.right, mid + 1, end, i, j)) ;
+	}
+
+	// copies the subtree at node into fresh once, children before parents
+	handle_t copy_imp(handle_t node, arena_t &fresh, std::vector<handle_t> &forward) {
+		if(node == null_node) {
+			return node ;
+		}
+		if(forward[node] != null_node) {
+			return forward[node] ;
+		}
+		const node_t n = nodes[node] ;
+		handle_t l = copy_imp(n.left, fresh, forward) ;
+		handle_t r = copy_imp(n.right, fresh, forward) ;
+		handle_t h = fresh.allocate() ;
+		node_t &c = fresh[h] ;
+		c.value = n.value ;
+		c.index = n.index ;
+		c.left = l ;
+		c.right = r ;
+		forward[node] = h ;
+		return h ;
+	}
+
+	const int *A ; // array ;
+	int array_size ;
+	int first_version ;             // version number of roots[0]
+	std::vector<handle_t> roots ;   // one root per retained version
+	arena_t nodes ;
+} ;
+}
+
+#endif
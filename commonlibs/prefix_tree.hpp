@@ -6,6 +6,22 @@
 #include <cctype> 
 #include <iostream>
 #include <vector> 
+#include <string>
+#include <thread>
+#include <atomic>
+#include <utility>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef COMMONLIBS_PREFETCH
+#if defined(__GNUC__)
+#define COMMONLIBS_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define COMMONLIBS_PREFETCH(p) ((void) 0)
+#endif
+#endif
+
 namespace commonlibs {
 
 	typedef struct Vertex {
@@ -13,14 +29,12 @@ namespace commonlibs {
 		int prefixes ;
 		enum { num_leaves = 26 } ; 
 		Vertex *edges [num_leaves] ;
-		Vertex *edges_refs [num_leaves] ;
 
 		Vertex () {
 			words = 0 ; 
 			prefixes = 0 ;
 			for(int i = 0 ;i < num_leaves ;++ i) {
 				edges[i] = NULL ;
-				edges_refs[i] = NULL ; 
 			}
 		} ;
 
@@ -109,7 +123,202 @@ namespace commonlibs {
 			
 			}
 			return cur->prefixes ;
-		}; 
+		};
+
+		// countWords for count words at once: out[k] gets the count of
+		// p_words[k], sizes[k] letters long.
+		//
+		// Up to batch_group lookups walk the trie in lock-step, one letter
+		// per round.  Each step prefetches the edge the lookup reads next
+		// and moves on to the other lookups, so the cache misses of the
+		// group overlap instead of being paid one node at a time.  A lane
+		// that finishes takes the next word at once.
+		void countWords_batch(const char * const *p_words, const size_t *sizes, size_t count, int *out) const {
+			batch_walk([p_words, sizes](size_t k) { return std::make_pair(p_words[k], sizes[k]) ; }, count, out) ;
+		}
+
+		std::vector<int> countWords_batch(const std::vector<std::string> &w) const {
+			std::vector<int> out(w.size()) ;
+			batch_walk([&w](size_t k) { return std::make_pair(w[k].data(), w[k].size()) ; }, w.size(), out.data()) ;
+			return out ;
+		}
+
+		// add every word in [first, last), with the same counts as calling
+		// addWord on each.  Elements need data() and size() (std::string,
+		// std::string_view).  With input sorted case-insensitively, each word
+		// starts from the node of its common prefix with the previous word
+		// rather than from the root; unsorted input is still counted right.
+		// Words are split by first letter and the subtrees are built by up to
+		// nthreads threads (0: one per hardware thread), then hang under this
+		// node as with addWord.
+		// returns: number of words added
+		template <class Iterator>
+		int build_from_sorted(Iterator first, Iterator last, unsigned int nthreads = 0) {
+			typedef std::vector<std::pair<const char *, size_t> > word_list ;
+			word_list groups[num_leaves] ;
+			for( ; first != last ; ++ first) {
+				const char *p = first->data() ;
+				const size_t n = first->size() ;
+				if(p == NULL || n == 0)
+					continue ;
+				if(! ::isalpha(p[0])) {
+					std::cerr << "only alphbets are allowed" << std::endl ;
+					continue ;
+				}
+				groups[::tolower(p[0]) - 'a'].push_back(std::make_pair(p, n)) ;
+			}
+			// the first-letter children are made here, so workers never
+			// touch this node
+			int busy = 0 ;
+			for(int c = 0 ; c < num_leaves ; ++ c) {
+				if(groups[c].empty())
+					continue ;
+				++ busy ;
+				if(edges[c] == NULL) {
+					edges[c] = new Vertex() ;
+					prefixes ++ ;
+				}
+			}
+			if(nthreads == 0)
+				nthreads = std::thread::hardware_concurrency() ;
+			if(nthreads > (unsigned int) busy)
+				nthreads = busy ;
+
+			std::atomic<int> next(0) ;
+			int added[num_leaves] = {0} ;
+			auto worker = [&]() {
+				for(int c = next ++ ; c < num_leaves ; c = next ++) {
+					if(! groups[c].empty())
+						added[c] = load_group(edges[c], groups[c]) ;
+				}
+			} ;
+			if(nthreads <= 1) {
+				worker() ;
+			}
+			else {
+				std::vector<std::thread> pool ;
+				for(unsigned int t = 0 ; t < nthreads ; ++ t)
+					pool.push_back(std::thread(worker)) ;
+				for(size_t t = 0 ; t < pool.size() ; ++ t)
+					pool[t].join() ;
+			}
+			int total = 0 ;
+			for(int c = 0 ; c < num_leaves ; ++ c)
+				total += added[c] ;
+			return total ;
+		}
+
+	private:
+		enum { batch_group = 16 } ;
+
+		// lanes 0 .. live - 1 hold a lookup each: the node reached, the
+		// letters left and the slot of out it answers
+		template <class Word>
+		void batch_walk(Word word, size_t count, int *out) const {
+			const Vertex *cur[batch_group] ;
+			const char *p[batch_group] ;
+			size_t left[batch_group], slot[batch_group] ;
+			size_t taken = 0 ;
+			// loads the next word that needs a walk into lane k
+			auto fill = [&](int k) -> bool {
+				while(taken < count) {
+					const std::pair<const char *, size_t> w = word(taken) ;
+					if(w.first == NULL || w.second == 0) {
+						out[taken ++] = words ;
+						continue ;
+					}
+					cur[k] = this ;
+					p[k] = w.first ;
+					left[k] = w.second ;
+					slot[k] = taken ++ ;
+					return true ;
+				}
+				return false ;
+			} ;
+			int live = 0 ;
+			while(live < batch_group && fill(live))
+				++ live ;
+			while(live > 0) {
+				for(int k = 0 ; k < live ; ) {
+					bool done = true ;
+					if(left[k] == 0) {
+						out[slot[k]] = cur[k]->words ;
+					}
+					else if(! ::isalpha((unsigned char) *p[k])) {
+						std::cerr << "only alphbets are allowed" << std::endl ;
+						out[slot[k]] = words ;
+					}
+					else {
+						const Vertex *n = cur[k]->edges[::tolower((unsigned char) *p[k]) - 'a'] ;
+						if(n == NULL) {
+							out[slot[k]] = 0 ;
+						}
+						else {
+							cur[k] = n ;
+							++ p[k] ;
+							-- left[k] ;
+							// the line read next round: an edge, or the count
+							if(left[k] > 0 && ::isalpha((unsigned char) *p[k]))
+								COMMONLIBS_PREFETCH(&n->edges[::tolower((unsigned char) *p[k]) - 'a']) ;
+							else
+								COMMONLIBS_PREFETCH(n) ;
+							done = false ;
+						}
+					}
+					if(! done) {
+						++ k ;
+					}
+					else if(! fill(k)) {
+						// no words left: the last lane takes this one's place
+						-- live ;
+						cur[k] = cur[live] ;
+						p[k] = p[live] ;
+						left[k] = left[live] ;
+						slot[k] = slot[live] ;
+					}
+				}
+			}
+		}
+
+		// adds the words of one first-letter group below sub, the node of
+		// their first letter.  path[d] is the node for the first d + 1
+		// letters of the previous word, spelled by prev.
+		static int load_group(Vertex *sub, const std::vector<std::pair<const char *, size_t> > &words) {
+			std::vector<Vertex *> path(1, sub) ;
+			std::string prev ;
+			int added = 0 ;
+			for(size_t w = 0 ; w < words.size() ; ++ w) {
+				const char *p = words[w].first ;
+				const size_t n = words[w].second ;
+				size_t k = 0 ;
+				while(k < prev.size() && k + 1 < n && ::tolower(p[k + 1]) == prev[k])
+					++ k ;
+				path.resize(k + 1) ;
+				prev.resize(k) ;
+				Vertex *cur = path[k] ;
+				bool valid = true ;
+				for(size_t j = k + 1 ; j < n ; ++ j) {
+					if(! ::isalpha(p[j])) {
+						std::cerr << "only alphbets are allowed" << std::endl ;
+						valid = false ;
+						break ;
+					}
+					const char lowerch = ::tolower(p[j]) ;
+					if(cur->edges[lowerch - 'a'] == NULL) {
+						cur->edges[lowerch - 'a'] = new Vertex() ;
+						cur->prefixes ++ ;
+					}
+					cur = cur->edges[lowerch - 'a'] ;
+					path.push_back(cur) ;
+					prev.push_back(lowerch) ;
+				}
+				if(valid) {
+					cur->words ++ ;
+					++ added ;
+				}
+			}
+			return added ;
+		}
 
 	} Vertex ;
 
@@ -121,6 +330,266 @@ namespace commonlibs {
 		traverser_Vertex (Vertex * v_) : v(v_), cindex(0) {} 
 	} traverser_Vertex ;
 
+	// Forward iterator over the words of a Vertex trie in alphabetical
+	// order, as (lowercase word, count) pairs.  Walks an explicit stack of
+	// traverser_Vertex, so nothing recurses and a loop can stop early.  A
+	// prefix limits the walk to the words starting with it.  The trie must
+	// not change while an iterator is in use.
+	class word_iterator {
+	public:
+		typedef std::forward_iterator_tag iterator_category ;
+		typedef std::pair<std::string, int> value_type ;
+		typedef std::ptrdiff_t difference_type ;
+		typedef const value_type * pointer ;
+		typedef const value_type & reference ;
+
+		// the end iterator
+		word_iterator() {}
+
+		// first word under root starting with p_word[0, size)
+		explicit word_iterator(Vertex *root, const char *p_word = NULL, size_t size = 0) {
+			Vertex *cur = root ;
+			for(size_t k = 0 ; cur != NULL && p_word != NULL && k < size ; ++ k) {
+				if(! ::isalpha((unsigned char) p_word[k])) {
+					std::cerr << "only alphbets are allowed" << std::endl ;
+					return ;
+				}
+				const char lowerch = ::tolower((unsigned char) p_word[k]) ;
+				current.first.push_back(lowerch) ;
+				cur = cur->edges[lowerch - 'a'] ;
+			}
+			if(cur == NULL) {
+				return ;
+			}
+			stack.push_back(traverser_Vertex(cur)) ;
+			if(cur->words > 0) {
+				current.second = cur->words ;
+			}
+			else {
+				advance() ;
+			}
+		}
+
+		reference operator*() const {
+			return current ;
+		}
+
+		pointer operator->() const {
+			return &current ;
+		}
+
+		word_iterator & operator++() {
+			advance() ;
+			return *this ;
+		}
+
+		word_iterator operator++(int) {
+			word_iterator old(*this) ;
+			advance() ;
+			return old ;
+		}
+
+		bool operator==(const word_iterator &o) const {
+			if(stack.empty() || o.stack.empty())
+				return stack.empty() == o.stack.empty() ;
+			return stack.back().v == o.stack.back().v ;
+		}
+
+		bool operator!=(const word_iterator &o) const {
+			return ! (*this == o) ;
+		}
+
+	private:
+		// preorder step to the next node holding a word; ends with an
+		// empty stack
+		void advance() {
+			while(! stack.empty()) {
+				traverser_Vertex &top = stack.back() ;
+				while(top.cindex < Vertex::num_leaves && top.v->edges[top.cindex] == NULL)
+					++ top.cindex ;
+				if(top.cindex == Vertex::num_leaves) {
+					stack.pop_back() ;
+					if(! stack.empty())
+						current.first.pop_back() ;
+					continue ;
+				}
+				Vertex *child = top.v->edges[top.cindex] ;
+				current.first.push_back((char) ('a' + top.cindex)) ;
+				++ top.cindex ;
+				stack.push_back(traverser_Vertex(child)) ;
+				if(child->words > 0) {
+					current.second = child->words ;
+					return ;
+				}
+			}
+		}
+
+		std::vector<traverser_Vertex> stack ;
+		value_type current ;
+	} ;
+
+	// a word of the trie within the edit distance of a fuzzy query
+	struct fuzzy_match {
+		std::string word ;   // lowercase
+		int count ;          // times the word was added
+		int distance ;       // Levenshtein distance to the query
+	} ;
+
+	// Forward iterator over the words of a Vertex trie within max_distance
+	// edits (insert, delete, substitute one letter) of a query, in
+	// alphabetical order.
+	//
+	// Walks the trie depth first and keeps one Levenshtein DP row per
+	// level: the row of a node is computed from its parent's in O(query
+	// length), and a subtree is skipped as soon as the smallest entry of
+	// its row exceeds max_distance, since no word below it can come back
+	// under the bound.  Only nodes near the query are ever visited, and
+	// the next match is only searched for on ++.
+	class fuzzy_iterator {
+	public:
+		typedef std::forward_iterator_tag iterator_category ;
+		typedef fuzzy_match value_type ;
+		typedef std::ptrdiff_t difference_type ;
+		typedef const value_type * pointer ;
+		typedef const value_type & reference ;
+
+		// the end iterator
+		fuzzy_iterator() {}
+
+		// first word under root within max_distance of p_word[0, size).
+		// only letters are allowed in the query, case is ignored.
+		fuzzy_iterator(Vertex *root, const char *p_word, size_t size, int max_distance) {
+			maxd = max_distance ;
+			if(root == NULL || maxd < 0) {
+				return ;
+			}
+			for(size_t k = 0 ; p_word != NULL && k < size ; ++ k) {
+				if(! ::isalpha((unsigned char) p_word[k])) {
+					std::cerr << "only alphbets are allowed" << std::endl ;
+					return ;
+				}
+				query.push_back((char) ::tolower((unsigned char) p_word[k])) ;
+			}
+			const size_t m = query.size() ;
+			rows.resize(m + 1) ;
+			for(size_t j = 0 ; j <= m ; ++ j)
+				rows[j] = (int) j ;
+			stack.push_back(traverser_Vertex(root)) ;
+			current.count = 0 ;
+			current.distance = 0 ;
+			if(root->words > 0 && (int) m <= maxd) {
+				current.count = root->words ;
+				current.distance = (int) m ;
+			}
+			else {
+				advance() ;
+			}
+		}
+
+		reference operator*() const {
+			return current ;
+		}
+
+		pointer operator->() const {
+			return &current ;
+		}
+
+		fuzzy_iterator & operator++() {
+			advance() ;
+			return *this ;
+		}
+
+		fuzzy_iterator operator++(int) {
+			fuzzy_iterator old(*this) ;
+			advance() ;
+			return old ;
+		}
+
+		bool operator==(const fuzzy_iterator &o) const {
+			if(stack.empty() || o.stack.empty())
+				return stack.empty() == o.stack.empty() ;
+			return stack.back().v == o.stack.back().v ;
+		}
+
+		bool operator!=(const fuzzy_iterator &o) const {
+			return ! (*this == o) ;
+		}
+
+	private:
+		// next node in preorder that ends a word within the bound; row d of
+		// rows belongs to stack[d]
+		void advance() {
+			const size_t m = query.size() ;
+			while(! stack.empty()) {
+				const size_t d = stack.size() - 1 ;
+				traverser_Vertex &top = stack.back() ;
+				while(top.cindex < Vertex::num_leaves && top.v->edges[top.cindex] == NULL)
+					++ top.cindex ;
+				if(top.cindex == Vertex::num_leaves) {
+					stack.pop_back() ;
+					if(! stack.empty())
+						current.word.pop_back() ;
+					continue ;
+				}
+				const int c = top.cindex ++ ;
+				Vertex *child = top.v->edges[c] ;
+				if(rows.size() < (d + 2) * (m + 1))
+					rows.resize((d + 2) * (m + 1)) ;
+				const int *prev = &rows[d * (m + 1)] ;
+				int *row = &rows[(d + 1) * (m + 1)] ;
+				row[0] = prev[0] + 1 ;
+				int best = row[0] ;
+				for(size_t j = 1 ; j <= m ; ++ j) {
+					int cost = prev[j - 1] + (query[j - 1] == 'a' + c ? 0 : 1) ;
+					if(prev[j] + 1 < cost) cost = prev[j] + 1 ;
+					if(row[j - 1] + 1 < cost) cost = row[j - 1] + 1 ;
+					row[j] = cost ;
+					if(cost < best) best = cost ;
+				}
+				if(best > maxd)
+					continue ; // nothing below can get back under the bound
+				stack.push_back(traverser_Vertex(child)) ;
+				current.word.push_back((char) ('a' + c)) ;
+				if(child->words > 0 && row[m] <= maxd) {
+					current.count = child->words ;
+					current.distance = row[m] ;
+					return ;
+				}
+			}
+		}
+
+		std::string query ;
+		int maxd ;
+		std::vector<int> rows ;
+		std::vector<traverser_Vertex> stack ;
+		value_type current ;
+	} ;
+
+	// the words of a trie near a query as a lazy range:
+	//   for(const fuzzy_match &m : fuzzy_search(&root, "helo", 4, 1)) ...
+	class fuzzy_search {
+	public:
+		fuzzy_search(Vertex *root_, const char *p_word, size_t size, int max_distance) {
+			root = root_ ;
+			if(p_word != NULL)
+				query.assign(p_word, size) ;
+			maxd = max_distance ;
+		}
+
+		fuzzy_iterator begin() const {
+			return fuzzy_iterator(root, query.data(), query.size(), maxd) ;
+		}
+
+		fuzzy_iterator end() const {
+			return fuzzy_iterator() ;
+		}
+
+	private:
+		Vertex *root ;
+		std::string query ;
+		int maxd ;
+	} ;
+
 
 	class traverser_tree {
 	public: 
@@ -143,6 +612,136 @@ namespace commonlibs {
 		}
 		std::vector<traverser_Vertex> v_t;
 	} ;
+
+	// Aho-Corasick automaton over the words of a Vertex trie, for finding
+	// all of them in a stream in one pass.
+	//
+	// compile() numbers the trie nodes breadth first and folds the failure
+	// links into a flat table of num_leaves moves per state, so every input
+	// byte costs one table read.  Each state also keeps the nearest state
+	// on its failure chain that ends a word, and feed() follows those links
+	// to report every word ending at a byte, overlapping ones included.
+	//
+	// Matching is on letters with case ignored, as in Vertex; any other
+	// byte is a separator that no word spans.  The automaton keeps its
+	// state between feed() calls, so a word split across two chunks is
+	// still found.  One stream per object: reset() starts another.
+	class aho_corasick {
+	public:
+		enum { num_leaves = Vertex::num_leaves } ;
+
+		// matches nothing until compiled
+		aho_corasick() {
+			clear() ;
+		}
+
+		// builds the automaton for the words under root.  The trie is only
+		// read and may be freed afterwards.
+		static aho_corasick compile(const Vertex &root) {
+			aho_corasick a ;
+			std::vector<const Vertex *> nodes(1, &root) ;
+			std::vector<int32_t> parent(1, 0) ;
+			std::vector<char> via(1, 0) ;
+			for(std::size_t s = 0 ; s < nodes.size() ; ++ s) {
+				const Vertex *v = nodes[s] ;
+				if(s > 0 && v->words > 0) {
+					std::string w ;
+					for(int32_t t = (int32_t) s ; t != 0 ; t = parent[t])
+						w.push_back(via[t]) ;
+					a.pattern_of[s] = (int32_t) a.patterns.size() ;
+					a.patterns.push_back(std::string(w.rbegin(), w.rend())) ;
+				}
+				for(int c = 0 ; c < num_leaves ; ++ c) {
+					const int32_t f = a.next[a.fail[s] * num_leaves + c] ;
+					if(v->edges[c] == NULL) {
+						// missing move: where the failure state goes
+						a.next[s * num_leaves + c] = s == 0 ? 0 : f ;
+						continue ;
+					}
+					const int32_t t = (int32_t) nodes.size() ;
+					nodes.push_back(v->edges[c]) ;
+					parent.push_back((int32_t) s) ;
+					via.push_back((char) ('a' + c)) ;
+					a.next[s * num_leaves + c] = t ;
+					a.next.resize(a.next.size() + num_leaves, 0) ;
+					// longest proper suffix in the trie; states of lower depth
+					// are numbered first, so its moves are already final
+					const int32_t tf = s == 0 ? 0 : f ;
+					a.fail.push_back(tf) ;
+					a.output.push_back(nodes[tf]->words > 0 && tf != 0 ? tf : a.output[tf]) ;
+					a.pattern_of.push_back(-1) ;
+				}
+			}
+			return a ;
+		}
+
+		// scans size bytes that follow everything fed before, and calls
+		// cb(end, pattern) for each word found: the word is pattern(pattern)
+		// and ends just before stream position end.
+		// returns: number of matches in this chunk
+		template <class Callback>
+		std::size_t feed(const char *p, size_t size, Callback cb) {
+			std::size_t found = 0 ;
+			int32_t s = state ;
+			for(size_t k = 0 ; k < size ; ++ k) {
+				const unsigned char ch = (unsigned char) p[k] ;
+				if(! ::isalpha(ch)) {
+					s = 0 ;
+					continue ;
+				}
+				s = next[s * num_leaves + (::tolower(ch) - 'a')] ;
+				for(int32_t t = pattern_of[s] >= 0 ? s : output[s] ; t > 0 ; t = output[t]) {
+					cb(position + k + 1, pattern_of[t]) ;
+					++ found ;
+				}
+			}
+			state = s ;
+			position += size ;
+			return found ;
+		}
+
+		// forgets the stream fed so far
+		void reset() {
+			state = 0 ;
+			position = 0 ;
+		}
+
+		// bytes fed since construction or reset()
+		uint64_t stream_position() const {
+			return position ;
+		}
+
+		// a matched word, lowercase
+		const std::string & pattern(int id) const {
+			return patterns[id] ;
+		}
+
+		std::size_t pattern_count() const {
+			return patterns.size() ;
+		}
+
+		std::size_t state_count() const {
+			return fail.size() ;
+		}
+
+	private:
+		void clear() {
+			next.assign(num_leaves, 0) ;
+			fail.assign(1, 0) ;
+			output.assign(1, -1) ;
+			pattern_of.assign(1, -1) ;
+			patterns.clear() ;
+			reset() ;
+		}
+
+		std::vector<int32_t> next ;        // state * num_leaves + letter -> state
+		std::vector<int32_t> fail ;        // longest proper suffix state
+		std::vector<int32_t> output ;      // nearest suffix state ending a word, -1 if none
+		std::vector<int32_t> pattern_of ;  // word ending at the state, -1 if none
+		std::vector<std::string> patterns ;
+		int32_t state ;
+		uint64_t position ;
+	} ;
 }
 
 
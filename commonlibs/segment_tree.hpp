@@ -1,87 +1,616 @@
-	
 #ifndef __COMMONLIBS_SEGMENTS_TREE_HPP
 
 #define __COMMONLIBS_SEGMENTS_TREE_HPP
 
-#include <iostream> 
-#include <cmath>
+#include <iostream>
+#include <climits>
+#include <limits>
+#include <numeric>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifndef COMMONLIBS_PREFETCH
+#if defined(__GNUC__)
+#define COMMONLIBS_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define COMMONLIBS_PREFETCH(p) ((void) 0)
+#endif
+#endif
 
 namespace commonlibs {
-// segment tree is a tree that can be used to find range minimum 
-class segments_tree {
+
+// Combiners for segment_tree<T, Op>.  A combiner is a default-constructible
+// functor with
+//     static T identity() ;                       // neutral element
+//     T operator()(const T &a, const T &b) const ; // associative, a left of b
+// It does not have to be commutative.
+
+template <class T>
+struct min_op {
+	static T identity() { return std::numeric_limits<T>::max() ; }
+	T operator()(const T &a, const T &b) const { return b < a ? b : a ; }
+} ;
+
+template <class T>
+struct max_op {
+	static T identity() { return std::numeric_limits<T>::lowest() ; }
+	T operator()(const T &a, const T &b) const { return a < b ? b : a ; }
+} ;
+
+template <class T>
+struct sum_op {
+	static T identity() { return T(0) ; }
+	T operator()(const T &a, const T &b) const { return a + b ; }
+} ;
+
+// T must be integral
+template <class T>
+struct gcd_op {
+	static T identity() { return T(0) ; }
+	T operator()(const T &a, const T &b) const { return std::gcd(a, b) ; }
+} ;
+
+// a value together with its position in the array
+template <class V>
+struct indexed_value {
+	V value ;
+	int index ;
+	indexed_value() : value(V()), index(-1) {}
+	indexed_value(const V &v, int i) : value(v), index(i) {}
+	bool operator==(const indexed_value &o) const { return value == o.value && index == o.index ; }
+	bool operator!=(const indexed_value &o) const { return !(*this == o) ; }
+} ;
+
+// minimum value and its index; the leftmost index wins on ties
+template <class V>
+struct argmin_op {
+	typedef indexed_value<V> T ;
+	static T identity() { return T(std::numeric_limits<V>::max(), INT_MAX) ; }
+	T operator()(const T &a, const T &b) const {
+		if(b.value < a.value || (!(a.value < b.value) && b.index < a.index))
+			return b ;
+		return a ;
+	}
+} ;
+
+// maximum value and its index; the leftmost index wins on ties
+template <class V>
+struct argmax_op {
+	typedef indexed_value<V> T ;
+	static T identity() { return T(std::numeric_limits<V>::lowest(), INT_MAX) ; }
+	T operator()(const T &a, const T &b) const {
+		if(a.value < b.value || (!(b.value < a.value) && b.index < a.index))
+			return b ;
+		return a ;
+	}
+} ;
+
+// Generic segment tree over the monoid (T, Op), values stored in the nodes.
+//
+// The tree is stored bottom-up in 2n slots: leaves live at t[n .. 2n-1] and
+// the parent of slot p is p/2, so build, query and update are all
+// iterative.  Op is a template parameter and gets inlined into the loops.
+template <class T, class Op>
+class segment_tree {
 public:
-	segments_tree(const int *A_,  int arraysize_) {
-		A = A_ ;
-		array_size =arraysize_ ;
-		msize = 0 ; 
-		if(arraysize_ > 0)  {
-			msize=   4 * arraysize_ ;
-			M = new int[ msize] ;
-			for(int k = 0 ; k < msize; ++k) {
-				M[k] = -1 ;
+	typedef T value_type ;
+	typedef Op combiner_type ;
+
+	explicit segment_tree(int n = 0) {
+		resize(n) ;
+	}
+
+	segment_tree(const T *values, int n) {
+		build(values, n) ;
+	}
+
+	// resets the tree to n identity elements
+	void resize(int n) {
+		n_ = n > 0 ? n : 0 ;
+		t.assign(2 * n_, Op::identity()) ;
+	}
+
+	// (re)builds the tree from values[0 .. n-1] in O(n)
+	void build(const T *values, int n) {
+		resize(n) ;
+		if(values == NULL) {
+			return ;
+		}
+		for(int k = 0 ; k < n_ ; ++ k) {
+			t[n_ + k] = values[k] ;
+		}
+		for(int p = n_ - 1 ; p > 0 ; -- p) {
+			t[p] = op(t[2 * p], t[2 * p + 1]) ;
+		}
+	}
+
+	// combination of elements [i, j] in array order, clamped to the array.
+	// returns Op::identity() if the range is empty.
+	T query(int i, int j) const {
+		if(i < 0) i = 0 ;
+		if(j >= n_) j = n_ - 1 ;
+		T left = Op::identity() ;
+		if(i > j) {
+			return left ;
+		}
+		T right = Op::identity() ;
+		for(int l = i + n_, r = j + n_ + 1 ; l < r ; l >>= 1, r >>= 1) {
+			if(l & 1) left = op(left, t[l ++]) ;
+			if(r & 1) right = op(t[-- r], right) ;
+		}
+		return op(left, right) ;
+	}
+
+	// answers count independent queries q[k] = (i, j) into out[k], with the
+	// same results as query(i, j).  See query_batch_visit.
+	void query_batch(const std::pair<int, int> *q, std::size_t count, T *out, unsigned int nthreads = 1) const {
+		query_batch_visit(q, count, [out](std::size_t k, const T &v) { out[k] = v ; }, nthreads) ;
+	}
+
+	std::vector<T> query_batch(const std::vector<std::pair<int, int> > &q, unsigned int nthreads = 1) const {
+		std::vector<T> out(q.size()) ;
+		query_batch(q.data(), q.size(), out.data(), nthreads) ;
+		return out ;
+	}
+
+	// batch driver: calls visit(k, result) once for every query q[k].
+	//
+	// Queries are advanced in lock-step groups of batch_group, one tree
+	// level per step.  The node addresses of a query only depend on (i, j),
+	// so after each step the next level of every query in the group is
+	// prefetched and the cache misses of the group overlap instead of being
+	// paid one query at a time.  With nthreads > 1 a large batch is cut
+	// into contiguous slices that run on their own threads; visit must then
+	// be safe to call concurrently for different k.
+	template <class Visit>
+	void query_batch_visit(const std::pair<int, int> *q, std::size_t count, Visit visit, unsigned int nthreads = 1) const {
+		if(count == 0 || q == NULL) {
+			return ;
+		}
+		std::size_t per_thread = min_queries_per_thread ;
+		if(nthreads > count / per_thread)
+			nthreads = (unsigned int) (count / per_thread) ;
+		if(nthreads <= 1) {
+			batch_slice(q, 0, count, visit) ;
+			return ;
+		}
+		std::vector<std::thread> workers ;
+		workers.reserve(nthreads - 1) ;
+		std::size_t slice = (count + nthreads - 1) / nthreads ;
+		for(unsigned int w = 1 ; w < nthreads ; ++ w) {
+			std::size_t begin = w * slice ;
+			std::size_t end = begin + slice < count ? begin + slice : count ;
+			if(begin >= end)
+				break ;
+			workers.push_back(std::thread([this, q, begin, end, visit]() { batch_slice(q, begin, end, visit) ; })) ;
+		}
+		batch_slice(q, 0, slice < count ? slice : count, visit) ;
+		for(std::size_t w = 0 ; w < workers.size() ; ++ w) {
+			workers[w].join() ;
+		}
+	}
+
+	// sets element i to value in O(log n).
+	// returns 0 on success, -1 if i is out of range.
+	int update(int i, const T &value) {
+		if(i < 0 || i >= n_) {
+			std::cerr << "Error, update index " << i << " out of range [0, " << n_ << ")" << std::endl ;
+			return -1 ;
+		}
+		int p = i + n_ ;
+		t[p] = value ;
+		for(p >>= 1 ; p > 0 ; p >>= 1) {
+			t[p] = op(t[2 * p], t[2 * p + 1]) ;
+		}
+		return 0 ;
+	}
+
+	// overwrites count consecutive elements starting at first with values,
+	// refreshing each affected parent once: O(count + log n).
+	// returns 0 on success, -1 if the run does not fit in the array.
+	int update(int first, const T *values, int count) {
+		if(count <= 0) {
+			return 0 ;
+		}
+		if(values == NULL || first < 0 || count > n_ - first) {
+			std::cerr << "Error, update range [" << first << ", " << first + count
+				<< ") out of range [0, " << n_ << ")" << std::endl ;
+			return -1 ;
+		}
+		for(int k = 0 ; k < count ; ++ k) {
+			t[n_ + first + k] = values[k] ;
+		}
+		// the ancestors of leaves [a, b] at height h are exactly [a>>h, b>>h]
+		int l = (first + n_) >> 1 ;
+		int r = (first + count - 1 + n_) >> 1 ;
+		for( ; r > 0 ; l >>= 1, r >>= 1) {
+			for(int p = (l > 0 ? l : 1) ; p <= r ; ++ p) {
+				t[p] = op(t[2 * p], t[2 * p + 1]) ;
 			}
-			
 		}
+		return 0 ;
 	}
 
-	void initialize(int node, int begin, int end) {
-		if(node >= msize) {
-			std::cerr << "Error, index " << node << " > msize =" << msize <<std::endl ;
+	const T & get(int i) const {
+		return t[i + n_] ;
+	}
+
+	int size() const {
+		return n_ ;
+	}
+
+private:
+	enum { batch_group = 16 } ;
+	enum { min_queries_per_thread = 4096 } ;
+
+	template <class Visit>
+	void batch_slice(const std::pair<int, int> *q, std::size_t begin, std::size_t end, Visit &visit) const {
+		int l[batch_group], r[batch_group] ;
+		T left[batch_group], right[batch_group] ;
+		for(std::size_t base = begin ; base < end ; base += batch_group) {
+			const int g = end - base < (std::size_t) batch_group ? (int) (end - base) : (int) batch_group ;
+			int active = 0 ;
+			for(int k = 0 ; k < g ; ++ k) {
+				int i = q[base + k].first, j = q[base + k].second ;
+				if(i < 0) i = 0 ;
+				if(j >= n_) j = n_ - 1 ;
+				left[k] = Op::identity() ;
+				right[k] = Op::identity() ;
+				if(i > j) {
+					l[k] = r[k] = 0 ;
+					continue ;
+				}
+				l[k] = i + n_ ;
+				r[k] = j + n_ + 1 ;
+				COMMONLIBS_PREFETCH(&t[l[k]]) ;
+				COMMONLIBS_PREFETCH(&t[r[k] - 1]) ;
+				++ active ;
+			}
+			while(active > 0) {
+				active = 0 ;
+				for(int k = 0 ; k < g ; ++ k) {
+					if(l[k] >= r[k])
+						continue ;
+					if(l[k] & 1) left[k] = op(left[k], t[l[k] ++]) ;
+					if(r[k] & 1) right[k] = op(t[-- r[k]], right[k]) ;
+					l[k] >>= 1 ;
+					r[k] >>= 1 ;
+					if(l[k] < r[k]) {
+						COMMONLIBS_PREFETCH(&t[l[k]]) ;
+						COMMONLIBS_PREFETCH(&t[r[k] - 1]) ;
+						++ active ;
+					}
+				}
+			}
+			for(int k = 0 ; k < g ; ++ k) {
+				visit(base + k, op(left[k], right[k])) ;
+			}
+		}
+	}
+
+	int n_ ;
+	std::vector<T> t ;
+	Op op ;
+} ;
+
+// segment tree is a tree that can be used to find range minimum
+//
+// Thin wrapper over segment_tree<indexed_value<int>, argmin_op<int> > that
+// keeps the original interface: build from an external int array, query
+// returns the index of the minimum.
+class segments_tree {
+public:
+	typedef segment_tree<indexed_value<int>, argmin_op<int> > tree_type ;
+
+	segments_tree(const int *A_,  int arraysize_) : tree(arraysize_) {
+		A = A_ ;
+	}
+
+	// builds the whole tree from A in O(n).  node/begin/end are kept for
+	// compatibility with the old recursive interface; the tree is always
+	// built over the full array.
+	void initialize(int node = 0, int begin = 0, int end = -1) {
+		(void) node ; (void) begin ; (void) end ;
+		if(tree.size() == 0 || A == NULL) {
 			return ;
 		}
-		if(begin == end) {
-			M[node] = begin ;
+		std::vector<indexed_value<int> > leaves(tree.size()) ;
+		for(int k = 0 ; k < tree.size() ; ++ k) {
+			leaves[k] = indexed_value<int>(A[k], k) ;
 		}
-		else {
-			initialize(  2* (node + 1) -1 , begin, (begin + end)/2) ;
-			initialize(  2* (node + 1)  ,  (begin + end)/2+ 1 , end) ;
-			if(A[M[2*(node+1)-1]] <= A[M[2*(node+1)]])
-				M[node] = M[2*(node+1)-1] ;
-			else
-				M[node] = M[2*(node+1)] ;
+		tree.build(leaves.data(), tree.size()) ;
+	}
 
+	// returns the index of the minimum in [i, j] (the leftmost one on ties),
+	// or -1 if the range does not overlap the array or initialize() has not
+	// run.  node is ignored.
+	int query(int node, int i, int j) const {
+		(void) node ;
+		if(i < 0) i = 0 ;
+		if(j >= tree.size()) j = tree.size() - 1 ;
+		if(i > j) {
+			return -1 ;
 		}
+		const int index = tree.query(i, j).index ;
+		return index == INT_MAX ? -1 : index ;
 	}
 
-	int query(int node, int i, int j) {
-		return query_imp(node, 0, array_size - 1, i, j) ;
+	// answers count independent queries q[k] = (i, j) into out[k], with the
+	// same results as query(0, i, j).  Lookups are interleaved with
+	// prefetching and, with nthreads > 1, large batches are split across
+	// threads (see segment_tree::query_batch_visit).
+	void query_batch(const std::pair<int, int> *q, std::size_t count, int *out, unsigned int nthreads = 1) const {
+		tree.query_batch_visit(q, count, [out](std::size_t k, const indexed_value<int> &v) {
+			out[k] = v.index == INT_MAX ? -1 : v.index ;
+		}, nthreads) ;
+	}
+
+	std::vector<int> query_batch(const std::vector<std::pair<int, int> > &q, unsigned int nthreads = 1) const {
+		std::vector<int> out(q.size()) ;
+		query_batch(q.data(), q.size(), out.data(), nthreads) ;
+		return out ;
 	}
 
-	~segments_tree() {
-		delete [] M ;
-	} 
+	// sets element i to value in O(log n).  The tree keeps its own copy of
+	// the values, the source array A is not written.
+	// returns 0 on success, -1 if i is out of range.
+	int update(int i, int value) {
+		return tree.update(i, indexed_value<int>(value, i)) ;
+	}
+
+	// overwrites count consecutive elements starting at first with values
+	// in O(count + log n).  returns 0 on success, -1 if out of range.
+	int update(int first, const int *values, int count) {
+		if(count <= 0) {
+			return 0 ;
+		}
+		if(values == NULL || first < 0 || count > tree.size() - first) {
+			std::cerr << "Error, update range [" << first << ", " << (long long) first + count
+				<< ") out of range [0, " << tree.size() << ")" << std::endl ;
+			return -1 ;
+		}
+		std::vector<indexed_value<int> > run(count) ;
+		for(int k = 0 ; k < count ; ++ k) {
+			run[k] = indexed_value<int>(values[k], first + k) ;
+		}
+		return tree.update(first, run.data(), count) ;
+	}
+
+	// current value of element i (reflects update() calls)
+	int value(int i) const {
+		return tree.get(i).value ;
+	}
+
+	int size() const {
+		return tree.size() ;
+	}
 
 private:
+	const int *A ; // array ;
+	tree_type tree ;
+
+} ;
+// range minimum tree with lazy propagation: range add and range assign in
+// O(log n), interleaved with range-minimum queries.
+//
+// Same interface as segments_tree (query returns the index of the leftmost
+// minimum).  Nodes live in a recursive heap layout (root 1, children 2p and
+// 2p+1) and carry pending add/assign tags that are pushed to the children
+// only when a later operation descends through them.
+class lazy_segments_tree {
+public:
+	lazy_segments_tree(const int *A_, int arraysize_) {
+		A = A_ ;
+		array_size = arraysize_ > 0 ? arraysize_ : 0 ;
+		built = false ;
+		int msize = array_size > 0 ? 4 * array_size : 0 ;
+		M.assign(msize, node_t()) ;
+		add_tag.assign(msize, 0) ;
+		set_tag.assign(msize, 0) ;
+		has_set.assign(msize, 0) ;
+	}
 
-	int query_imp(int node, int begin, int end, int i, int j) {
-		if( i > end || j < begin) {
+	// builds the whole tree from A in O(n); node/begin/end are ignored as
+	// in segments_tree::initialize.
+	void initialize(int node = 0, int begin = 0, int end = -1) {
+		(void) node ; (void) begin ; (void) end ;
+		if(array_size == 0 || A == NULL) {
+			return ;
+		}
+		build_imp(1, 0, array_size - 1) ;
+		built = true ;
+	}
+
+	// returns the index of the minimum in [i, j] (the leftmost one on ties),
+	// or -1 if the range does not overlap the array or the tree is not
+	// initialized.  node is ignored.
+	int query(int node, int i, int j) {
+		(void) node ;
+		if(! built) {
+			return -1 ;
+		}
+		if(i < 0) i = 0 ;
+		if(j >= array_size) j = array_size - 1 ;
+		if(i > j) {
 			return -1 ;
 		}
+		return query_imp(1, 0, array_size - 1, i, j).index ;
+	}
 
-		if(begin >= i && end <= j) {
-			return M[node] ;
+	// minimum value in [i, j]; INT_MAX if the range does not overlap or
+	// the tree is not initialized
+	int query_value(int i, int j) {
+		if(! built) {
+			return INT_MAX ;
+		}
+		if(i < 0) i = 0 ;
+		if(j >= array_size) j = array_size - 1 ;
+		if(i > j) {
+			return INT_MAX ;
+		}
+		return query_imp(1, 0, array_size - 1, i, j).value ;
+	}
+
+	// adds delta to every element of [i, j].
+	// returns 0 on success, -1 if the range is invalid or the tree is not
+	// initialized.
+	int add(int i, int j, int delta) {
+		if(!check_built() || !check_range(i, j)) {
+			return -1 ;
 		}
+		add_imp(1, 0, array_size - 1, i, j, delta) ;
+		return 0 ;
+	}
 
-		int left = query_imp( 2* (node+1)-1,  begin, (begin+end)/2 , i, j) ;
-		int right =query_imp(2*(node+1) , (begin+end)/2 + 1, end, i, j) ;
-		if(left == -1) 
-			return right ;
-		if(right == -1) 
-			return left ;
+	// sets every element of [i, j] to value.
+	// returns 0 on success, -1 if the range is invalid or the tree is not
+	// initialized.
+	int assign(int i, int j, int value) {
+		if(!check_built() || !check_range(i, j)) {
+			return -1 ;
+		}
+		assign_imp(1, 0, array_size - 1, i, j, value) ;
+		return 0 ;
+	}
+
+	// current value of element i; INT_MAX if the tree is not initialized
+	int value(int i) {
+		if(! built) {
+			return INT_MAX ;
+		}
+		return query_imp(1, 0, array_size - 1, i, i).value ;
+	}
+
+	int size() const {
+		return array_size ;
+	}
 
-		if(A[left]<= A[right])
-			return left; 
+private:
+	struct node_t {
+		int value ;
+		int index ;
+		node_t() : value(INT_MAX), index(INT_MAX) {}
+		node_t(int v, int i) : value(v), index(i) {}
+	} ;
 
-		return right ;
+	static node_t min_node(const node_t &a, const node_t &b) {
+		if(a.value < b.value || (a.value == b.value && a.index < b.index))
+			return a ;
+		return b ;
+	}
 
+	// before initialize() every node is the INT_MAX identity, which add
+	// would overflow
+	bool check_built() const {
+		if(! built) {
+			std::cerr << "Error, lazy_segments_tree is not initialized" << std::endl ;
+			return false ;
+		}
+		return true ;
 	}
 
-	const int *A ; // array ; 
-	int array_size ; 
-	int *M ;
-	int msize ;
+	bool check_range(int i, int j) const {
+		if(i < 0 || j >= array_size || i > j) {
+			std::cerr << "Error, range [" << i << ", " << j << "] invalid for size " << array_size << std::endl ;
+			return false ;
+		}
+		return true ;
+	}
+
+	void build_imp(int node, int begin, int end) {
+		add_tag[node] = 0 ;
+		has_set[node] = 0 ;
+		if(begin == end) {
+			M[node] = node_t(A[begin], begin) ;
+			return ;
+		}
+		int mid = (begin + end) / 2 ;
+		build_imp(2 * node, begin, mid) ;
+		build_imp(2 * node + 1, mid + 1, end) ;
+		M[node] = min_node(M[2 * node], M[2 * node + 1]) ;
+	}
+
+	// every element of the node becomes value, the leftmost one is begin
+	void apply_assign(int node, int begin, int value) {
+		M[node] = node_t(value, begin) ;
+		set_tag[node] = value ;
+		has_set[node] = 1 ;
+		add_tag[node] = 0 ;
+	}
+
+	void apply_add(int node, int delta) {
+		M[node].value += delta ;
+		if(has_set[node])
+			set_tag[node] += delta ;
+		else
+			add_tag[node] += delta ;
+	}
+
+	void push_down(int node, int begin, int mid) {
+		if(has_set[node]) {
+			apply_assign(2 * node, begin, set_tag[node]) ;
+			apply_assign(2 * node + 1, mid + 1, set_tag[node]) ;
+			has_set[node] = 0 ;
+		}
+		if(add_tag[node] != 0) {
+			apply_add(2 * node, add_tag[node]) ;
+			apply_add(2 * node + 1, add_tag[node]) ;
+			add_tag[node] = 0 ;
+		}
+	}
+
+	node_t query_imp(int node, int begin, int end, int i, int j) {
+		if(i > end || j < begin) {
+			return node_t() ;
+		}
+		if(begin >= i && end <= j) {
+			return M[node] ;
+		}
+		int mid = (begin + end) / 2 ;
+		push_down(node, begin, mid) ;
+		return min_node(query_imp(2 * node, begin, mid, i, j),
+				query_imp(2 * node + 1, mid + 1, end, i, j)) ;
+	}
+
+	void add_imp(int node, int begin, int end, int i, int j, int delta) {
+		if(i > end || j < begin) {
+			return ;
+		}
+		if(begin >= i && end <= j) {
+			apply_add(node, delta) ;
+			return ;
+		}
+		int mid = (begin + end) / 2 ;
+		push_down(node, begin, mid) ;
+		add_imp(2 * node, begin, mid, i, j, delta) ;
+		add_imp(2 * node + 1, mid + 1, end, i, j, delta) ;
+		M[node] = min_node(M[2 * node], M[2 * node + 1]) ;
+	}
+
+	void assign_imp(int node, int begin, int end, int i, int j, int value) {
+		if(i > end || j < begin) {
+			return ;
+		}
+		if(begin >= i && end <= j) {
+			apply_assign(node, begin, value) ;
+			return ;
+		}
+		int mid = (begin + end) / 2 ;
+		push_down(node, begin, mid) ;
+		assign_imp(2 * node, begin, mid, i, j, value) ;
+		assign_imp(2 * node + 1, mid + 1, end, i, j, value) ;
+		M[node] = min_node(M[2 * node], M[2 * node + 1]) ;
+	}
 
+	const int *A ; // array ;
+	int array_size ;
+	bool built ;   // initialize() has filled M from A
+	std::vector<node_t> M ;
+	std::vector<int> add_tag ;
+	std::vector<int> set_tag ;
+	std::vector<char> has_set ;
 } ;
 }
 
-#endif 
\ No newline at end of file
+#endif
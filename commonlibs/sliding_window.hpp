@@ -0,0 +1,213 @@
+#ifndef __COMMONLIBS_SLIDING_WINDOW_HPP
+
+#define __COMMONLIBS_SLIDING_WINDOW_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "commonlibs/segment_tree.hpp"
+
+namespace commonlibs {
+// Streaming aggregates over the last W samples of an unbounded stream.
+// Both windows take the same combiners as segment_tree<T, Op> (min_op,
+// max_op, sum_op, gcd_op, argmin_op, custom structs ...), so the functor
+// that answers range queries on a stored array also answers "over the last
+// W samples" on a live stream without rebuilding anything.
+//
+// push() appends a sample and evicts the oldest once W samples are held,
+// pop() evicts the oldest explicitly, query() combines the window from
+// oldest to newest.  push_batch() ingests a run of samples and can write
+// the window aggregate after each one.
+
+// General monoid window with two stacks, amortised O(1) push/pop and O(1)
+// query.  New samples go on the back stack, which keeps one running
+// aggregate.  The front stack holds the older samples with their suffix
+// aggregates (each entry combines itself with everything newer in the
+// stack) and is refilled from the back stack only when it runs empty, so
+// every sample is combined a constant number of times.  Op need not be
+// commutative.
+template <class T, class Op>
+class sliding_window {
+public:
+	typedef T value_type ;
+	typedef Op combiner_type ;
+
+	explicit sliding_window(std::size_t capacity_) {
+		cap = capacity_ > 0 ? capacity_ : 1 ;
+		front.reserve(cap) ;
+		back.reserve(cap) ;
+		back_agg = Op::identity() ;
+	}
+
+	void push(const T &x) {
+		if(size() == cap) {
+			pop() ;
+		}
+		back.push_back(x) ;
+		back_agg = op(back_agg, x) ;
+	}
+
+	// removes the oldest sample; does nothing on an empty window
+	void pop() {
+		if(front.empty()) {
+			if(back.empty()) {
+				return ;
+			}
+			// move back to front, newest first, building suffix aggregates
+			T agg = Op::identity() ;
+			for(std::size_t k = back.size() ; k > 0 ; -- k) {
+				agg = op(back[k - 1], agg) ;
+				front.push_back(agg) ;
+			}
+			back.clear() ;
+			back_agg = Op::identity() ;
+		}
+		front.pop_back() ;
+	}
+
+	// aggregate of the window, oldest to newest; Op::identity() if empty
+	T query() const {
+		if(front.empty()) {
+			return back_agg ;
+		}
+		return op(front.back(), back_agg) ;
+	}
+
+	// pushes n samples; if out is not NULL, out[k] receives query() right
+	// after values[k] was pushed
+	void push_batch(const T *values, std::size_t n, T *out = NULL) {
+		for(std::size_t k = 0 ; k < n ; ++ k) {
+			push(values[k]) ;
+			if(out != NULL)
+				out[k] = query() ;
+		}
+	}
+
+	std::size_t size() const {
+		return front.size() + back.size() ;
+	}
+
+	bool empty() const {
+		return size() == 0 ;
+	}
+
+	std::size_t capacity() const {
+		return cap ;
+	}
+
+	void clear() {
+		front.clear() ;
+		back.clear() ;
+		back_agg = Op::identity() ;
+	}
+
+private:
+	std::size_t cap ;
+	std::vector<T> front ;  // suffix aggregates, oldest sample on top
+	std::vector<T> back ;   // raw samples, newest at the end
+	T back_agg ;
+	Op op ;
+} ;
+
+// Window for selective combiners, where op(a, b) is always a or b
+// (min_op, max_op, argmin_op, argmax_op): a monotonic deque in a ring
+// buffer, O(1) amortised push/pop and O(1) query with at most one
+// comparison per sample in and out.  A sample is dropped from the deque as
+// soon as a newer one wins against it, since it can never be the answer
+// again.  T must be equality comparable.
+template <class T, class Op>
+class monotonic_window {
+public:
+	typedef T value_type ;
+	typedef Op combiner_type ;
+
+	explicit monotonic_window(std::size_t capacity_) {
+		cap = capacity_ > 0 ? capacity_ : 1 ;
+		ring.resize(cap) ;
+		head = 0 ;
+		count = 0 ;
+		next_seq = 0 ;
+		oldest_seq = 0 ;
+	}
+
+	void push(const T &x) {
+		if(next_seq - oldest_seq == cap) {
+			pop() ;
+		}
+		// drop newer-side entries that x beats; on a tie op keeps the older
+		while(count > 0 && op(at(count - 1).value, x) == x) {
+			-- count ;
+		}
+		entry_t &e = ring[(head + count) % cap] ;
+		e.value = x ;
+		e.seq = next_seq ++ ;
+		++ count ;
+	}
+
+	// removes the oldest sample; does nothing on an empty window
+	void pop() {
+		if(next_seq == oldest_seq) {
+			return ;
+		}
+		if(count > 0 && at(0).seq == oldest_seq) {
+			head = (head + 1) % cap ;
+			-- count ;
+		}
+		++ oldest_seq ;
+	}
+
+	// winner of the window; Op::identity() if empty
+	T query() const {
+		return count > 0 ? at(0).value : Op::identity() ;
+	}
+
+	// pushes n samples; if out is not NULL, out[k] receives query() right
+	// after values[k] was pushed
+	void push_batch(const T *values, std::size_t n, T *out = NULL) {
+		for(std::size_t k = 0 ; k < n ; ++ k) {
+			push(values[k]) ;
+			if(out != NULL)
+				out[k] = at(0).value ;
+		}
+	}
+
+	std::size_t size() const {
+		return (std::size_t) (next_seq - oldest_seq) ;
+	}
+
+	bool empty() const {
+		return size() == 0 ;
+	}
+
+	std::size_t capacity() const {
+		return cap ;
+	}
+
+	void clear() {
+		head = 0 ;
+		count = 0 ;
+		oldest_seq = next_seq ;
+	}
+
+private:
+	struct entry_t {
+		T value ;
+		uint64_t seq ;  // position of the sample in the stream
+	} ;
+
+	const entry_t & at(std::size_t k) const {
+		return ring[(head + k) % cap] ;
+	}
+
+	std::size_t cap ;
+	std::vector<entry_t> ring ;  // candidates, oldest first
+	std::size_t head ;
+	std::size_t count ;
+	uint64_t next_seq ;
+	uint64_t oldest_seq ;
+	Op op ;
+} ;
+}
+
+#endif
@@ -0,0 +1,211 @@
+#ifndef __COMMONLIBS_SPARSE_SEGMENT_TREE_HPP
+
+#define __COMMONLIBS_SPARSE_SEGMENT_TREE_HPP
+
+#include <iostream>
+#include <cstdint>
+#include <vector>
+
+#include "commonlibs/arena.hpp"
+#include "commonlibs/segment_tree.hpp"
+
+namespace commonlibs {
+// dynamic segment tree over the 64-bit key range [lo, hi], for sparse keys
+// such as timestamps.  Op is a combiner as for segment_tree<T, Op>
+// (min_op, max_op, sum_op, ...), and keys that were never written hold
+// Op::identity().
+//
+// Nodes are created only for touched keys and come from a chunk_arena
+// (32-bit handles, no pointers).  Each node covers an aligned block of
+// 2^bits keys; a child may skip levels, so a branch node only exists where
+// the keys below it actually diverge.  k touched keys therefore cost at
+// most 2k - 1 nodes whatever the width of [lo, hi], and every operation
+// visits at most 64 levels.
+template <class T, class Op>
+class sparse_segment_tree {
+	typedef uint64_t ukey_t ;
+
+	struct node_t {
+		ukey_t start ;      // first key offset covered
+		int bits ;          // covers 2^bits keys; 0 for a leaf
+		T value ;
+		uint32_t child[2] ;
+	} ;
+	// 1024 nodes per chunk: a tree with a handful of keys stays a few KB
+	typedef chunk_arena<node_t, 10> arena_t ;
+
+public:
+	typedef T value_type ;
+	typedef typename arena_t::handle_t handle_t ;
+
+	sparse_segment_tree(int64_t lo_, int64_t hi_) {
+		lo = lo_ ;
+		hi = hi_ < lo_ ? lo_ : hi_ ;
+		root = null_node ;
+		nkeys = 0 ;
+	}
+
+	// sets the element at key to value.
+	// returns 0 on success, -1 if key is outside [lo, hi].
+	int update(int64_t key, const T &value) {
+		return write(key, value, false) ;
+	}
+
+	// combines value into the element at key: element = Op(element, value),
+	// e.g. an add for sum_op.  returns 0 on success, -1 if out of range.
+	int merge(int64_t key, const T &value) {
+		return write(key, value, true) ;
+	}
+
+	// combination of all elements with keys in [a, b], in key order;
+	// Op::identity() if nothing was written there.
+	T query(int64_t a, int64_t b) const {
+		if(a < lo) a = lo ;
+		if(b > hi) b = hi ;
+		if(a > b || root == null_node) {
+			return Op::identity() ;
+		}
+		return query_imp(root, offset(a), offset(b)) ;
+	}
+
+	// element at key; Op::identity() if it was never written
+	T get(int64_t key) const {
+		return query(key, key) ;
+	}
+
+	// number of distinct keys written
+	std::size_t size() const {
+		return nkeys ;
+	}
+
+	std::size_t node_count() const {
+		return nodes.size() ;
+	}
+
+	std::size_t bytes_reserved() const {
+		return nodes.bytes_reserved() ;
+	}
+
+	void clear() {
+		nodes.clear() ;
+		root = null_node ;
+		nkeys = 0 ;
+	}
+
+	int64_t lower_bound_key() const {
+		return lo ;
+	}
+
+	int64_t upper_bound_key() const {
+		return hi ;
+	}
+
+private:
+	static constexpr handle_t null_node = arena_t::null_handle ;
+	enum { max_depth = 65 } ;
+
+	ukey_t offset(int64_t key) const {
+		return (ukey_t) key - (ukey_t) lo ;
+	}
+
+	static ukey_t last_of(const node_t &n) {
+		return n.bits >= 64 ? ~(ukey_t) 0 : n.start + (((ukey_t) 1 << n.bits) - 1) ;
+	}
+
+	static bool covers(const node_t &n, ukey_t u) {
+		return u >= n.start && u <= last_of(n) ;
+	}
+
+	handle_t make_leaf(ukey_t u, const T &value) {
+		handle_t h = nodes.allocate() ;
+		node_t &n = nodes[h] ;
+		n.start = u ;
+		n.bits = 0 ;
+		n.value = value ;
+		n.child[0] = n.child[1] = null_node ;
+		++ nkeys ;
+		return h ;
+	}
+
+	// smallest aligned block holding both u and the block of node other,
+	// with other and a new leaf for u as its two children
+	handle_t make_branch(handle_t other, ukey_t u, const T &value) {
+		const ukey_t s = nodes[other].start ;
+		const int bits = 64 - __builtin_clzll(s ^ u) ;
+		handle_t leaf = make_leaf(u, value) ;
+		handle_t h = nodes.allocate() ;
+		node_t &n = nodes[h] ;
+		n.bits = bits ;
+		n.start = bits >= 64 ? 0 : (u >> bits) << bits ;
+		const int side = (int) ((u >> (bits - 1)) & 1) ;
+		n.child[side] = leaf ;
+		n.child[1 - side] = other ;
+		n.value = Op::identity() ;
+		return h ;
+	}
+
+	void pull(handle_t h) {
+		node_t &n = nodes[h] ;
+		T l = n.child[0] == null_node ? Op::identity() : nodes[n.child[0]].value ;
+		T r = n.child[1] == null_node ? Op::identity() : nodes[n.child[1]].value ;
+		n.value = op(l, r) ;
+	}
+
+	int write(int64_t key, const T &value, bool combine) {
+		if(key < lo || key > hi) {
+			std::cerr << "Error, key " << key << " out of range [" << lo << ", " << hi << "]" << std::endl ;
+			return -1 ;
+		}
+		const ukey_t u = offset(key) ;
+		handle_t path[max_depth] ;
+		int depth = 0 ;
+		handle_t *slot = &root ;
+		for(;;) {
+			if(*slot == null_node) {
+				*slot = make_leaf(u, combine ? op(Op::identity(), value) : value) ;
+				break ;
+			}
+			const handle_t h = *slot ;
+			if(!covers(nodes[h], u)) {
+				*slot = make_branch(h, u, combine ? op(Op::identity(), value) : value) ;
+				path[depth ++] = *slot ;
+				break ;
+			}
+			node_t &n = nodes[h] ;
+			if(n.bits == 0) {
+				n.value = combine ? op(n.value, value) : value ;
+				break ;
+			}
+			path[depth ++] = h ;
+			slot = &n.child[(u >> (n.bits - 1)) & 1] ;
+		}
+		// chunks never move, so the handles on the path are still valid
+		while(depth > 0) {
+			pull(path[-- depth]) ;
+		}
+		return 0 ;
+	}
+
+	T query_imp(handle_t h, ukey_t a, ukey_t b) const {
+		const node_t &n = nodes[h] ;
+		const ukey_t s = n.start, e = last_of(n) ;
+		if(b < s || a > e) {
+			return Op::identity() ;
+		}
+		if(a <= s && e <= b) {
+			return n.value ;
+		}
+		T l = n.child[0] == null_node ? Op::identity() : query_imp(n.child[0], a, b) ;
+		T r = n.child[1] == null_node ? Op::identity() : query_imp(n.child[1], a, b) ;
+		return op(l, r) ;
+	}
+
+	int64_t lo, hi ;
+	handle_t root ;
+	std::size_t nkeys ;
+	arena_t nodes ;
+	Op op ;
+} ;
+}
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef __COMMONLIBS_SPARSE_TABLE_HPP
+
+#define __COMMONLIBS_SPARSE_TABLE_HPP
+
+#include <iostream>
+#include <cstdint>
+#include <vector>
+
+namespace commonlibs {
+// static range minimum in O(1) per query, for arrays that never change
+// after load.  Drop-in for segments_tree: same constructor, initialize()
+// and query() returning the index of the leftmost minimum.
+//
+// Level k holds the minimum of every window of 2^k elements.  Each entry is
+// a 64-bit key (order-preserving value << 32 | index), so a plain unsigned
+// min picks the smallest value and, on ties, the smallest index.  Building
+// a level is then one branch-free min pass over two shifted copies of the
+// previous level, which the compiler vectorises; a query is two loads and
+// one min.  Memory is n * (floor(log2 n) + 1) keys.
+class sparse_table_rmq {
+public:
+	sparse_table_rmq(const int *A_, int arraysize_) {
+		A = A_ ;
+		array_size = arraysize_ > 0 ? arraysize_ : 0 ;
+	}
+
+	// builds all levels from A in O(n log n).  node/begin/end are kept for
+	// compatibility with segments_tree::initialize and are ignored.
+	void initialize(int node = 0, int begin = 0, int end = -1) {
+		(void) node ; (void) begin ; (void) end ;
+		levels.clear() ;
+		if(array_size == 0 || A == NULL) {
+			return ;
+		}
+		int nlevels = floor_log2(array_size) + 1 ;
+		levels.resize(nlevels) ;
+		levels[0].resize(array_size) ;
+		for(int k = 0 ; k < array_size ; ++ k) {
+			levels[0][k] = make_key(A[k], k) ;
+		}
+		for(int lv = 1 ; lv < nlevels ; ++ lv) {
+			const int half = 1 << (lv - 1) ;
+			const int count = array_size - (1 << lv) + 1 ;
+			levels[lv].resize(count) ;
+			min_pass(levels[lv - 1].data(), levels[lv - 1].data() + half, levels[lv].data(), count) ;
+		}
+	}
+
+	// returns the index of the minimum in [i, j] (the leftmost one on ties),
+	// or -1 if the range does not overlap the array.  node is ignored.
+	int query(int node, int i, int j) const {
+		(void) node ;
+		return query(i, j) ;
+	}
+
+	int query(int i, int j) const {
+		if(i < 0) i = 0 ;
+		if(j >= array_size) j = array_size - 1 ;
+		if(i > j || levels.empty()) {
+			return -1 ;
+		}
+		const int lv = floor_log2(j - i + 1) ;
+		const std::vector<uint64_t> &row = levels[lv] ;
+		uint64_t a = row[i] ;
+		uint64_t b = row[j - (1 << lv) + 1] ;
+		return (int) (uint32_t) (a < b ? a : b) ;
+	}
+
+	int size() const {
+		return array_size ;
+	}
+
+private:
+	static int floor_log2(unsigned int x) {
+		return 31 - __builtin_clz(x) ;
+	}
+
+	// maps int order onto unsigned order in the high half, index in the low
+	static uint64_t make_key(int value, int index) {
+		uint64_t v = (uint64_t) ((uint32_t) value ^ 0x80000000u) ;
+		return (v << 32) | (uint32_t) index ;
+	}
+
+	static void min_pass(const uint64_t *lo, const uint64_t *hi, uint64_t *out, int count) {
+		for(int k = 0 ; k < count ; ++ k) {
+			out[k] = hi[k] < lo[k] ? hi[k] : lo[k] ;
+		}
+	}
+
+	const int *A ; // array ;
+	int array_size ;
+	std::vector<std::vector<uint64_t> > levels ;
+} ;
+}
+
+#endif
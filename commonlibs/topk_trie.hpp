@@ -0,0 +1,185 @@
+#ifndef __COMMONLIBS_TOPK_TRIE_HPP
+
+#define __COMMONLIBS_TOPK_TRIE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cctype>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace commonlibs {
+// Weighted trie for type-ahead: complete() returns the heaviest words under
+// a prefix in O(prefix length + k), with no subtree walk.
+//
+// Every node caches the ids of the k heaviest words below it, best first.
+// Weights only grow, so an add can change a cache in one way: the word it
+// touched moves up, or enters in place of the last entry.  addWord fixes
+// the caches on its path from the word's node upwards, and stops at the
+// first cache the word does not get into: an ancestor's k-th entry is at
+// least as heavy as its descendant's.  Ties are broken alphabetically.
+//
+// Letters only and case ignored, as in Vertex; words are kept lowercase.
+class topk_trie {
+public:
+	enum { num_leaves = 26 } ;
+	typedef std::pair<std::string, long long> completion ;
+
+	// k: completions cached per node, the most complete() can return
+	explicit topk_trie(std::size_t k_ = 10) {
+		k = k_ == 0 ? 1 : k_ ;
+	}
+
+	~topk_trie() {
+		destroy(&root) ;
+	}
+
+	topk_trie(const topk_trie &) = delete ;
+	topk_trie & operator=(const topk_trie &) = delete ;
+
+	// adds weight to the word, which starts at 0.  weight must not be
+	// negative: cached completions are only valid while weights grow.
+	// returns: the word's weight after the add, -1 on error
+	long long addWord(const char *p_word, size_t size, long long weight = 1) {
+		if(p_word == NULL || size == 0) {
+			return -1 ;
+		}
+		if(weight < 0) {
+			std::cerr << "weights may only grow" << std::endl ;
+			return -1 ;
+		}
+		for(size_t j = 0 ; j < size ; ++ j) {
+			if(! ::isalpha((unsigned char) p_word[j])) {
+				std::cerr << "only alphbets are allowed" << std::endl ;
+				return -1 ;
+			}
+		}
+		path.resize(size + 1) ;
+		node_t *cur = &root ;
+		path[0] = cur ;
+		for(size_t j = 0 ; j < size ; ++ j) {
+			const int c = ::tolower((unsigned char) p_word[j]) - 'a' ;
+			if(cur->edges[c] == NULL)
+				cur->edges[c] = new node_t() ;
+			cur = cur->edges[c] ;
+			path[j + 1] = cur ;
+		}
+		if(cur->word < 0) {
+			cur->word = (int32_t) words.size() ;
+			words.push_back(std::string(p_word, size)) ;
+			for(size_t j = 0 ; j < size ; ++ j)
+				words.back()[j] = (char) ::tolower((unsigned char) p_word[j]) ;
+			weights.push_back(0) ;
+		}
+		const int32_t id = cur->word ;
+		weights[id] += weight ;
+		for(size_t j = size + 1 ; j > 0 ; -- j) {
+			if(! promote(path[j - 1]->top, id))
+				break ;
+		}
+		return weights[id] ;
+	}
+
+	// weight of the word, 0 if it was never added
+	long long weight(const char *p_word, size_t size) const {
+		const node_t *n = find(p_word, size) ;
+		return n == NULL || n->word < 0 ? 0 : weights[n->word] ;
+	}
+
+	// the n heaviest words starting with the prefix, heaviest first.  n is
+	// capped at k().
+	std::vector<completion> complete(const char *p_word, size_t size, std::size_t n) const {
+		std::vector<completion> out ;
+		const node_t *node = find(p_word, size) ;
+		if(node == NULL)
+			return out ;
+		const std::size_t m = n < node->top.size() ? n : node->top.size() ;
+		out.reserve(m) ;
+		for(std::size_t j = 0 ; j < m ; ++ j)
+			out.push_back(completion(words[node->top[j]], weights[node->top[j]])) ;
+		return out ;
+	}
+
+	std::vector<completion> complete(const char *p_word, size_t size) const {
+		return complete(p_word, size, k) ;
+	}
+
+	// number of distinct words
+	std::size_t size() const {
+		return words.size() ;
+	}
+
+	std::size_t top_k() const {
+		return k ;
+	}
+
+private:
+	struct node_t {
+		int32_t word ;                 // id of the word ending here, -1 if none
+		node_t *edges[num_leaves] ;
+		std::vector<int32_t> top ;     // ids of the heaviest words below, best first
+		node_t() : word(-1) {
+			for(int i = 0 ; i < num_leaves ; ++ i)
+				edges[i] = NULL ;
+		}
+	} ;
+
+	// node of the prefix, or NULL.  p_word NULL or empty gives the root.
+	const node_t * find(const char *p_word, size_t size) const {
+		const node_t *cur = &root ;
+		for(size_t j = 0 ; p_word != NULL && j < size ; ++ j) {
+			if(! ::isalpha((unsigned char) p_word[j])) {
+				std::cerr << "only alphbets are allowed" << std::endl ;
+				return NULL ;
+			}
+			cur = cur->edges[::tolower((unsigned char) p_word[j]) - 'a'] ;
+			if(cur == NULL)
+				return NULL ;
+		}
+		return cur ;
+	}
+
+	bool better(int32_t a, int32_t b) const {
+		return weights[a] > weights[b] || (weights[a] == weights[b] && words[a] < words[b]) ;
+	}
+
+	// moves id to its place in top after its weight grew.  returns false
+	// if it does not make the cache
+	bool promote(std::vector<int32_t> &top, int32_t id) const {
+		std::size_t pos = 0 ;
+		while(pos < top.size() && top[pos] != id)
+			++ pos ;
+		if(pos == top.size()) {
+			if(top.size() < k)
+				top.push_back(id) ;
+			else if(better(id, top.back()))
+				top.back() = id ;
+			else
+				return false ;
+			pos = top.size() - 1 ;
+		}
+		for( ; pos > 0 && better(top[pos], top[pos - 1]) ; -- pos)
+			std::swap(top[pos], top[pos - 1]) ;
+		return true ;
+	}
+
+	static void destroy(node_t *n) {
+		for(int i = 0 ; i < num_leaves ; ++ i) {
+			if(n->edges[i] != NULL) {
+				destroy(n->edges[i]) ;
+				delete n->edges[i] ;
+			}
+		}
+	}
+
+	std::size_t k ;
+	node_t root ;
+	std::vector<std::string> words ;   // by id, lowercase
+	std::vector<long long> weights ;   // by id
+	std::vector<node_t *> path ;       // scratch for addWord
+} ;
+}
+
+#endif
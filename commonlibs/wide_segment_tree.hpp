@@ -0,0 +1,261 @@
+#ifndef __COMMONLIBS_WIDE_SEGMENT_TREE_HPP
+
+#define __COMMONLIBS_WIDE_SEGMENT_TREE_HPP
+
+#include <iostream>
+#include <climits>
+#include <vector>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+namespace commonlibs {
+// key encoding and masked block scan shared by the B-ary trees
+// (wide_segments_tree, mapped_segments_tree); p must be 16-byte aligned
+template <int B>
+struct wide_block_ops {
+	static_assert(B >= 2 && (B & (B - 1)) == 0, "B must be a power of two >= 2") ;
+	typedef long long key_t ;
+
+	static key_t make_key(int value, unsigned int index) {
+		return (key_t) value * 4294967296LL + index ;
+	}
+
+	static key_t empty_key() {
+		return LLONG_MAX ;
+	}
+
+	static unsigned int key_index(key_t k) {
+		return (unsigned int) (k & 0xffffffffLL) ;
+	}
+
+	static int key_value(key_t k) {
+		return (int) ((k - (k & 0xffffffffLL)) / 4294967296LL) ;
+	}
+
+	// minimum of p[lo .. hi] inside one block: one masked min reduction
+	// over the whole block, vectorised where the target has 64-bit compares
+	// (SSE4.2, e.g. -msse4.2 or -march=native); block_min_scalar otherwise
+	static key_t block_min(const key_t *p, unsigned int lo, unsigned int hi) {
+#if defined(__SSE4_2__)
+		const __m128i vmax = _mm_set1_epi64x(LLONG_MAX) ;
+		const __m128i vlo = _mm_set1_epi64x((long long) lo - 1) ;
+		const __m128i vhi = _mm_set1_epi64x((long long) hi + 1) ;
+		__m128i lane = _mm_set_epi64x(1, 0) ;
+		const __m128i step = _mm_set1_epi64x(2) ;
+		__m128i acc = vmax ;
+		for(int k = 0 ; k < B ; k += 2) {
+			__m128i x = _mm_load_si128((const __m128i *) (p + k)) ;
+			__m128i in = _mm_and_si128(_mm_cmpgt_epi64(lane, vlo), _mm_cmpgt_epi64(vhi, lane)) ;
+			x = select(in, x, vmax) ;
+			acc = select(_mm_cmpgt_epi64(acc, x), x, acc) ;
+			lane = _mm_add_epi64(lane, step) ;
+		}
+		__m128i hi2 = _mm_unpackhi_epi64(acc, acc) ;
+		acc = select(_mm_cmpgt_epi64(acc, hi2), hi2, acc) ;
+		return _mm_cvtsi128_si64(acc) ;
+#else
+		return block_min_scalar(p, lo, hi) ;
+#endif
+	}
+
+	// the same scan one key at a time, the reference for the vector one
+	static key_t block_min_scalar(const key_t *p, unsigned int lo, unsigned int hi) {
+		key_t m = empty_key() ;
+		for(unsigned int k = 0 ; k < (unsigned int) B ; ++ k) {
+			key_t x = (k >= lo && k <= hi) ? p[k] : empty_key() ;
+			m = x < m ? x : m ;
+		}
+		return m ;
+	}
+
+#if defined(__SSE4_2__)
+	// mask ? a : b with and/andnot/or; run WideBlockOps tests under
+	// -march=native before trying _mm_blendv_epi8 here
+	static __m128i select(__m128i mask, __m128i a, __m128i b) {
+		return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)) ;
+	}
+#endif
+} ;
+
+// B-ary range minimum tree: every node is one block of B contiguous keys
+// (B = 8 keys of 64 bits is one cache line) and the tree is B-tree ordered
+// bottom up.  Level 0 holds the elements, entry e of level L+1 is the
+// minimum of block e of level L.  A key is value * 2^32 + index, so a
+// signed 64-bit min picks the smallest value and, on ties, the leftmost
+// index; the answer never needs a second pass down the tree.
+//
+// A query scans at most two partial blocks per level with one masked min
+// reduction each.  Which blocks are read only depends on i and j, so the
+// loads of all levels are independent and overlap; a query touches about
+// 2 * log_B(n) cache lines instead of 2 * log_2(n) for segments_tree.
+//
+// Same interface as segments_tree: query returns the index of the leftmost
+// minimum; update(i, value) is O(B log_B n).
+template <int B = 8>
+class wide_segments_tree {
+	static_assert(B >= 2 && (B & (B - 1)) == 0, "B must be a power of two >= 2") ;
+public:
+	typedef long long key_t ;
+
+	wide_segments_tree(const int *A_, int arraysize_) {
+		A = A_ ;
+		array_size = arraysize_ > 0 ? arraysize_ : 0 ;
+		height = 0 ;
+	}
+
+	// builds all levels from A in O(n).  node/begin/end are kept for
+	// compatibility with segments_tree::initialize and are ignored.
+	void initialize(int node = 0, int begin = 0, int end = -1) {
+		(void) node ; (void) begin ; (void) end ;
+		level_offset.clear() ;
+		blocks.clear() ;
+		height = 0 ;
+		if(array_size == 0 || A == NULL) {
+			return ;
+		}
+		// level sizes in blocks, bottom up, until one block covers everything
+		int entries = array_size ;
+		int total = 0 ;
+		for(;;) {
+			int nblocks = (entries + B - 1) / B ;
+			level_offset.push_back(total) ;
+			total += nblocks ;
+			++ height ;
+			if(nblocks == 1)
+				break ;
+			entries = nblocks ;
+		}
+		level_offset.push_back(total) ;
+		blocks.assign(total, block_t()) ;
+		for(int k = 0 ; k < array_size ; ++ k) {
+			blocks[k / B].v[k % B] = make_key(A[k], k) ;
+		}
+		for(int lv = 1 ; lv < height ; ++ lv) {
+			const int below = level_offset[lv] - level_offset[lv - 1] ;
+			block_t *dst = &blocks[level_offset[lv]] ;
+			for(int e = 0 ; e < below ; ++ e) {
+				dst[e / B].v[e % B] = block_min(blocks[level_offset[lv - 1] + e].v, 0, B - 1) ;
+			}
+		}
+	}
+
+	// returns the index of the minimum in [i, j] (the leftmost one on ties),
+	// or -1 if the range does not overlap the array.  node is ignored.
+	int query(int node, int i, int j) const {
+		(void) node ;
+		return query(i, j) ;
+	}
+
+	int query(int i, int j) const {
+		if(i < 0) i = 0 ;
+		if(j >= array_size) j = array_size - 1 ;
+		if(i > j || height == 0) {
+			return -1 ;
+		}
+		key_t best = empty_key() ;
+		unsigned int l = i, r = j ;
+		for(int lv = 0 ; lv < height ; ++ lv) {
+			const block_t *base = &blocks[level_offset[lv]] ;
+			const unsigned int bl = l / B, br = r / B ;
+			if(bl == br) {
+				key_t m = block_min(base[bl].v, l % B, r % B) ;
+				best = m < best ? m : best ;
+				break ;
+			}
+			// a block covered completely is handled one level up
+			if(l % B != 0) {
+				key_t m = block_min(base[bl].v, l % B, B - 1) ;
+				best = m < best ? m : best ;
+				l = bl + 1 ;
+			}
+			else {
+				l = bl ;
+			}
+			if(r % B != B - 1) {
+				key_t m = block_min(base[br].v, 0, r % B) ;
+				best = m < best ? m : best ;
+				r = br - 1 ;
+			}
+			else {
+				r = br ;
+			}
+			if(l > r || r == (unsigned int) -1)
+				break ;
+		}
+		return key_index(best) ;
+	}
+
+	// sets element i to value in O(B log_B n).  The tree keeps its own copy
+	// of the values, the source array A is not written.
+	// returns 0 on success, -1 if i is out of range.
+	int update(int i, int value) {
+		if(i < 0 || i >= array_size || height == 0) {
+			std::cerr << "Error, update index " << i << " out of range [0, " << array_size << ")" << std::endl ;
+			return -1 ;
+		}
+		blocks[i / B].v[i % B] = make_key(value, i) ;
+		int e = i / B ;
+		for(int lv = 1 ; lv < height ; ++ lv) {
+			blocks[level_offset[lv] + e / B].v[e % B] = block_min(blocks[level_offset[lv - 1] + e].v, 0, B - 1) ;
+			e /= B ;
+		}
+		return 0 ;
+	}
+
+	// current value of element i (reflects update() calls)
+	int value(int i) const {
+		return key_value(blocks[i / B].v[i % B]) ;
+	}
+
+	int size() const {
+		return array_size ;
+	}
+
+	int levels() const {
+		return height ;
+	}
+
+private:
+	typedef wide_block_ops<B> ops ;
+
+	// a block is one cache line for B = 8, and never padded for smaller B
+	struct alignas(B * sizeof(key_t) < 64 ? B * sizeof(key_t) : 64) block_t {
+		key_t v[B] ;
+		block_t() {
+			for(int k = 0 ; k < B ; ++ k)
+				v[k] = ops::empty_key() ;
+		}
+	} ;
+
+	static key_t make_key(int value, int index) {
+		return ops::make_key(value, (unsigned int) index) ;
+	}
+
+	static key_t empty_key() {
+		return ops::empty_key() ;
+	}
+
+	static int key_index(key_t k) {
+		return (int) ops::key_index(k) ;
+	}
+
+	static int key_value(key_t k) {
+		return ops::key_value(k) ;
+	}
+
+	static key_t block_min(const key_t *p, unsigned int lo, unsigned int hi) {
+		return ops::block_min(p, lo, hi) ;
+	}
+
+
+	const int *A ; // array ;
+	int array_size ;
+	int height ;
+	std::vector<int> level_offset ; // first block of each level, plus the end
+	std::vector<block_t> blocks ;
+} ;
+}
+
+#endif
@@ -0,0 +1,158 @@
+#include "commonlibs/adaptive_radix_tree.hpp"
+#include "commonlibs/prefix_tree.hpp"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+static int countW(const commonlibs::adaptive_radix_tree &t, const std::string &w)
+{
+    return t.countWords(w.data(), w.size());
+}
+
+static int countP(const commonlibs::adaptive_radix_tree &t, const std::string &w)
+{
+    return t.countPrefixes(w.data(), w.size());
+}
+
+// reference: distinct bytes following prefix among the keys
+static int followers(const std::map<std::string, int> &keys, const std::string &prefix)
+{
+    std::set<unsigned char> next;
+    for (auto it = keys.lower_bound(prefix); it != keys.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it)
+        if (it->first.size() > prefix.size())
+            next.insert((unsigned char)it->first[prefix.size()]);
+    return (int)next.size();
+}
+
+TEST(AdaptiveRadixTree, AddAndCount)
+{
+    commonlibs::adaptive_radix_tree t;
+    EXPECT_EQ(1, t.addWord("hello", 5));
+    EXPECT_EQ(2, t.addWord("hello", 5));
+    t.addWord("help", 4);
+    EXPECT_EQ(2, countW(t, "hello"));
+    EXPECT_EQ(1, countW(t, "help"));
+    EXPECT_EQ(0, countW(t, "hel"));
+    EXPECT_EQ(0, countW(t, "helpful"));
+    EXPECT_EQ(0, countW(t, "Hello"));   // bytes, not letters: case matters
+    EXPECT_EQ(2u, t.size());
+}
+
+TEST(AdaptiveRadixTree, KeysThatArePrefixesOfEachOther)
+{
+    commonlibs::adaptive_radix_tree t;
+    t.addWord("abcdef", 6);
+    t.addWord("abc", 3);
+    t.addWord("", 0);
+    t.addWord("abcdefghijklmnopqrstuvwxyz", 26);
+    t.addWord("abcdefghijklmnopq", 17);
+    EXPECT_EQ(1, countW(t, ""));
+    EXPECT_EQ(1, countW(t, "abc"));
+    EXPECT_EQ(1, countW(t, "abcdef"));
+    EXPECT_EQ(1, countW(t, "abcdefghijklmnopq"));
+    EXPECT_EQ(1, countW(t, "abcdefghijklmnopqrstuvwxyz"));
+    EXPECT_EQ(0, countW(t, "abcdefghijklmnop"));
+    EXPECT_EQ(0, countW(t, "abcd"));
+    EXPECT_EQ(1, countP(t, "abcd"));     // inside a collapsed path
+    EXPECT_EQ(1, countP(t, "abc"));
+    EXPECT_EQ(0, countP(t, "abcdefghijklmnopqrstuvwxyz"));
+    EXPECT_EQ(0, countP(t, "abcdefghijklmnopqrstuvwxyZ"));
+}
+
+TEST(AdaptiveRadixTree, ArbitraryBytes)
+{
+    commonlibs::adaptive_radix_tree t;
+    const char k1[] = {'a', '\0', 'b'};
+    const char k2[] = {'a', '\0', 'c'};
+    const char k3[] = {(char)0xff, (char)0x80};
+    t.addWord(k1, 3);
+    t.addWord(k2, 3);
+    t.addWord(k3, 2);
+    EXPECT_EQ(1, t.countWords(k1, 3));
+    EXPECT_EQ(1, t.countWords(k2, 3));
+    EXPECT_EQ(1, t.countWords(k3, 2));
+    EXPECT_EQ(0, t.countWords(k1, 2));
+    EXPECT_EQ(2, t.countPrefixes(k1, 2));
+    EXPECT_EQ(2, t.countPrefixes("", 0));
+}
+
+TEST(AdaptiveRadixTree, NodesGrowThroughAllSizes)
+{
+    commonlibs::adaptive_radix_tree t;
+    // one byte after "x" takes every value: Node4 -> 16 -> 48 -> 256
+    for (int c = 255; c >= 0; --c) {
+        char key[3] = {'x', (char)c, 'y'};
+        t.addWord(key, 3);
+        ASSERT_EQ(256 - c, t.countPrefixes("x", 1));
+    }
+    for (int c = 0; c < 256; ++c) {
+        char key[3] = {'x', (char)c, 'y'};
+        ASSERT_EQ(1, t.countWords(key, 3)) << c;
+        ASSERT_EQ(0, t.countWords(key, 2)) << c;
+    }
+    EXPECT_EQ(256u, t.size());
+    std::size_t bytes = t.memory_usage();
+    t.clear();
+    EXPECT_EQ(0u, t.size());
+    EXPECT_EQ(0u, t.memory_usage());
+    EXPECT_GT(bytes, 0u);
+}
+
+TEST(AdaptiveRadixTree, AgreesWithReferenceOnUrlLikeKeys)
+{
+    const char *hosts[] = {"http://example.com/", "https://example.com/", "https://example.org/a/", "ftp://x/"};
+    commonlibs::adaptive_radix_tree t;
+    std::map<std::string, int> ref;
+    unsigned seed = 123;
+    for (int k = 0; k < 4000; ++k) {
+        seed = seed * 1103515245u + 12345u;
+        std::string w = hosts[(seed >> 16) % 4];
+        int len = (int)((seed >> 8) % 12);
+        for (int c = 0; c < len; ++c) {
+            seed = seed * 1103515245u + 12345u;
+            w.push_back("abc/._-0123456789"[(seed >> 16) % 17]);
+        }
+        ++ref[w];
+        ASSERT_EQ(ref[w], t.addWord(w.data(), w.size()));
+    }
+    EXPECT_EQ(ref.size(), t.size());
+    for (const auto &kv : ref) {
+        const std::string &w = kv.first;
+        ASSERT_EQ(kv.second, countW(t, w)) << w;
+        for (std::size_t len = 0; len <= w.size(); ++len) {
+            std::string p = w.substr(0, len);
+            ASSERT_EQ(ref.count(p) ? ref[p] : 0, countW(t, p)) << p;
+            ASSERT_EQ(followers(ref, p), countP(t, p)) << p;
+        }
+        ASSERT_EQ(0, countW(t, w + "~"));
+        ASSERT_EQ(0, countP(t, w + "~"));
+    }
+}
+
+TEST(AdaptiveRadixTree, MatchesVertexOnLetters)
+{
+    commonlibs::Vertex v;
+    commonlibs::adaptive_radix_tree t;
+    std::vector<std::string> words;
+    unsigned seed = 9;
+    for (int k = 0; k < 2000; ++k) {
+        seed = seed * 1103515245u + 12345u;
+        int len = 1 + (int)((seed >> 16) % 9);
+        std::string w;
+        for (int c = 0; c < len; ++c) {
+            seed = seed * 1103515245u + 12345u;
+            w.push_back((char)('a' + (seed >> 16) % 4));
+        }
+        words.push_back(w);
+        v.addWord(w.c_str(), w.size());
+        t.addWord(w.c_str(), w.size());
+    }
+    for (const std::string &w : words)
+        for (std::size_t len = 1; len <= w.size(); ++len) {
+            ASSERT_EQ(v.countWords(w.c_str(), len), t.countWords(w.c_str(), len));
+            ASSERT_EQ(v.countPrefixes(w.c_str(), len), t.countPrefixes(w.c_str(), len));
+        }
+}
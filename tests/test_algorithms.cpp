@@ -1,6 +1,8 @@
 #include <string>
 #include <sstream>
 #include <functional>
+#include <set>
+#include <tuple>
 #include "commonlibs/algorithms.hpp"
 #include <gtest/gtest.h>
 
@@ -326,3 +328,548 @@ TEST(Dijkstra, DiamondGraph)
     // 0->1->3 = 3; 0->2->3 = 6
     EXPECT_EQ(3, dist(3));
 }
+
+// ---- csr_graph ---------------------------------------------------------------
+
+static G_vvii random_graph(int n, int m, unsigned seed, int maxw)
+{
+    G_vvii g = make_graph(n);
+    for (int k = 0; k < m; ++k) {
+        seed = seed * 1103515245u + 12345u;
+        int u = (int)((seed >> 8) % n);
+        seed = seed * 1103515245u + 12345u;
+        int v = (int)((seed >> 8) % n);
+        seed = seed * 1103515245u + 12345u;
+        add_edge(g, u, v, (int)((seed >> 8) % (maxw + 1)));
+    }
+    return g;
+}
+
+template <class Graph>
+static std::string all_paths(const Graph &g, int from, int n)
+{
+    shortest_path_algo algo;
+    algo.Dijkstra(g, from);
+    return capture_cout([&]{ for (int v = 0; v < n; ++v) algo.print_path(v); });
+}
+
+TEST(CsrGraph, BuildFromEdgeListGroupsBySource)
+{
+    std::vector<graph_edge> edges = {{2, 0, 4}, {0, 1, 1}, {2, 1, 7}, {0, 2, 3}};
+    csr_graph g;
+    ASSERT_EQ(0, g.build(3, edges));
+    EXPECT_EQ(3, g.vertex_count());
+    EXPECT_EQ(4u, g.edge_count());
+    ASSERT_EQ(2u, g.end(0) - g.begin(0));
+    EXPECT_EQ(1, g.target(g.begin(0)));       // list order kept
+    EXPECT_EQ(3, g.weight(g.begin(0) + 1));
+    EXPECT_EQ(g.begin(1), g.end(1));          // no out-edges
+    EXPECT_EQ(0, g.target(g.begin(2)));
+    EXPECT_EQ(7, g.weight(g.begin(2) + 1));
+
+    std::ostringstream oss;
+    std::streambuf *olderr = std::cerr.rdbuf(oss.rdbuf());
+    EXPECT_EQ(-1, g.build(2, edges));         // vertex 2 out of range
+    G_vvii bad = make_graph(2);
+    add_edge(bad, 0, 5, 1);
+    EXPECT_EQ(-1, g.build(bad));
+    std::cerr.rdbuf(olderr);
+    EXPECT_EQ(0, g.vertex_count());
+}
+
+TEST(CsrGraph, EmptyGraph)
+{
+    csr_graph g;
+    ASSERT_EQ(0, g.build(0, std::vector<graph_edge>()));
+    EXPECT_EQ(0, g.vertex_count());
+    ASSERT_EQ(0, g.build(G_vvii()));
+    EXPECT_EQ(0u, g.edge_count());
+}
+
+TEST(CsrGraph, DijkstraMatchesAdjacencyLists)
+{
+    for (unsigned seed : {1u, 2u, 3u}) {
+        G_vvii g = random_graph(200, 900, seed, 20);
+        csr_graph from_lists;
+        ASSERT_EQ(0, from_lists.build(g));
+        std::vector<graph_edge> edges;
+        for (int u = 0; u < (int)g.size(); ++u)
+            for (const gedge &e : g[u])
+                edges.push_back(graph_edge{u, e.second, e.first});
+        csr_graph from_edges;
+        ASSERT_EQ(0, from_edges.build((int)g.size(), edges));
+
+        std::string want = all_paths(g, 0, 200);
+        EXPECT_EQ(want, all_paths(from_lists, 0, 200));
+        EXPECT_EQ(want, all_paths(from_edges, 0, 200));
+    }
+}
+
+TEST(CsrGraph, DijkstraEarlyStopAndBadSource)
+{
+    G_vvii g = make_graph(3);
+    add_edge(g, 0, 1, 2);
+    add_edge(g, 1, 2, 2);
+    csr_graph c;
+    ASSERT_EQ(0, c.build(g));
+    shortest_path_algo algo;
+    EXPECT_EQ(0, algo.Dijkstra(c, 0, 1));
+    EXPECT_EQ(2, extract_distance(capture_cout([&]{ algo.print_path(1); })));
+
+    std::ostringstream oss;
+    std::streambuf *olderr = std::cerr.rdbuf(oss.rdbuf());
+    EXPECT_EQ(-1, algo.Dijkstra(c, 3));
+    std::cerr.rdbuf(olderr);
+}
+
+TEST(Dijkstra, RerunAfterEarlyStopStartsClean)
+{
+    // the first search stops at 1 and leaves (1, 2) queued; the second must
+    // not pop it and stop at 2 before 3 -> 4 -> 2 has been found
+    G_vvii g = make_graph(5);
+    add_edge(g, 0, 1, 1);
+    add_edge(g, 0, 2, 1);
+    add_edge(g, 3, 4, 5);
+    add_edge(g, 4, 2, 1);
+    add_edge(g, 3, 2, 10);
+    shortest_path_algo algo;
+    algo.Dijkstra(g, 0, 1);
+    algo.Dijkstra(g, 3, 2);
+    EXPECT_EQ(6, extract_distance(capture_cout([&]{ algo.print_path(2); })));
+}
+
+// ---- reused workspace --------------------------------------------------------
+
+TEST(Dijkstra, DistanceAccessor)
+{
+    G_vvii g = make_graph(3);
+    add_edge(g, 0, 1, 4);
+    shortest_path_algo algo;
+    EXPECT_EQ(-1, algo.distance(0));          // nothing searched yet
+    algo.Dijkstra(g, 0);
+    EXPECT_EQ(0, algo.distance(0));
+    EXPECT_EQ(4, algo.distance(1));
+    EXPECT_EQ((int)shortest_path_algo::unreached, algo.distance(2));
+    EXPECT_EQ(-1, algo.distance(3));
+    EXPECT_EQ(-1, algo.distance(-1));
+}
+
+TEST(Dijkstra, ReachedVertexForgottenByNextSearch)
+{
+    G_vvii g = make_graph(3);
+    add_edge(g, 0, 1, 2);
+    add_edge(g, 1, 2, 2);
+    shortest_path_algo algo;
+    algo.Dijkstra(g, 0);
+    algo.Dijkstra(g, 1);
+    std::string out = capture_cout([&]{ algo.print_path(0); });
+    EXPECT_EQ(987654321, extract_distance(out));
+    EXPECT_EQ((std::vector<int>{0}), extract_path(out));
+    EXPECT_EQ((std::vector<int>{2, 1}), extract_path(capture_cout([&]{ algo.print_path(2); })));
+}
+
+TEST(Dijkstra, RepeatedQueriesMatchFreshSearches)
+{
+    G_vvii g = random_graph(300, 1200, 11, 30);
+    csr_graph c;
+    ASSERT_EQ(0, c.build(g));
+    shortest_path_algo reused;
+    unsigned seed = 8;
+    for (int q = 0; q < 60; ++q) {
+        seed = seed * 1103515245u + 12345u;
+        int from = (int)((seed >> 8) % 300);
+        seed = seed * 1103515245u + 12345u;
+        int to = q % 3 == 0 ? -1 : (int)((seed >> 8) % 300);
+        shortest_path_algo fresh;
+        fresh.Dijkstra(g, from, to);
+        if (q % 2)
+            reused.Dijkstra(c, from, to);
+        else
+            reused.Dijkstra(g, from, to);
+        if (to >= 0) {
+            ASSERT_EQ(fresh.distance(to), reused.distance(to)) << q;
+        }
+        else {
+            for (int v = 0; v < 300; ++v)
+                ASSERT_EQ(fresh.distance(v), reused.distance(v)) << q << " " << v;
+        }
+    }
+    // a graph of another size reallocates
+    G_vvii small = make_graph(2);
+    add_edge(small, 1, 0, 3);
+    reused.Dijkstra(small, 1);
+    EXPECT_EQ(3, reused.distance(0));
+    EXPECT_EQ(-1, reused.distance(2));
+}
+
+// ---- queue policies ----------------------------------------------------------
+
+template <class Queue>
+class QueuePolicy : public ::testing::Test {};
+
+typedef ::testing::Types<binary_heap_queue, radix_heap_queue, dial_queue, indexed_heap_queue<4>, indexed_heap_queue<2> >
+    queue_policies;
+TYPED_TEST_SUITE(QueuePolicy, queue_policies);
+
+TYPED_TEST(QueuePolicy, PopsInOrderUnderMonotonePushes)
+{
+    TypeParam q;
+    q.prepare(5000);
+    unsigned seed = 17;
+    int last = 0, pushed = 0, popped = 0, next_vertex = 0;
+    for (int round = 0; round < 2; ++round) {
+        q.clear();
+        last = 0;
+        while (popped < 4000 * (round + 1)) {
+            seed = seed * 1103515245u + 12345u;
+            if (pushed - popped < 50 && next_vertex < 5000 * (round + 1) && (seed >> 16) % 3 != 0) {
+                // each vertex once, so the indexed heaps see plain inserts
+                seed = seed * 1103515245u + 12345u;
+                int span = (seed >> 20) % 4 == 0 ? 100000 : 50;
+                q.push(last + (int)((seed >> 8) % span), next_vertex++ % 5000);
+                ++pushed;
+            }
+            else if (!q.empty()) {
+                gedge e = q.pop();
+                ASSERT_GE(e.first, last);
+                last = e.first;
+                ++popped;
+            }
+        }
+        while (!q.empty()) {
+            gedge e = q.pop();
+            ASSERT_GE(e.first, last);
+            last = e.first;
+            ++popped;
+        }
+        pushed = popped;
+    }
+}
+
+TYPED_TEST(QueuePolicy, DijkstraMatchesBinaryHeap)
+{
+    for (int maxw : {0, 1, 9, 1000, 2000000}) {
+        G_vvii g = random_graph(400, 2000, 31 + maxw, maxw);
+        csr_graph c;
+        ASSERT_EQ(0, c.build(g));
+        shortest_path_algo reference;
+        basic_shortest_path_algo<TypeParam> algo;
+        for (int from : {0, 7, 399}) {
+            reference.Dijkstra(g, from);
+            algo.Dijkstra(c, from);
+            for (int v = 0; v < 400; ++v)
+                ASSERT_EQ(reference.distance(v), algo.distance(v)) << "maxw " << maxw << " from " << from << " v " << v;
+            algo.Dijkstra(g, from, (from + 13) % 400);
+            ASSERT_EQ(reference.distance((from + 13) % 400), algo.distance((from + 13) % 400));
+        }
+    }
+}
+
+TYPED_TEST(QueuePolicy, PrintPathKeepsSentinel)
+{
+    G_vvii g = make_graph(3);
+    add_edge(g, 0, 1, 5);
+    basic_shortest_path_algo<TypeParam> algo;
+    algo.Dijkstra(g, 0);
+    EXPECT_EQ(5, extract_distance(capture_cout([&]{ algo.print_path(1); })));
+    EXPECT_EQ(987654321, extract_distance(capture_cout([&]{ algo.print_path(2); })));
+}
+
+TEST(DialQueue, ClearDropsWhatIsLeftAfterAnEarlyExit)
+{
+    dial_queue q;
+    q.prepare(10);
+    q.push(0, 1);
+    q.push(3, 2);
+    q.push(100000, 3);   // grows the ring
+    q.push(5, 4);
+    EXPECT_EQ(gedge(0, 1), q.pop());
+    EXPECT_EQ(gedge(3, 2), q.pop());
+    q.clear();
+    EXPECT_TRUE(q.empty());
+    q.push(0, 7);
+    q.push(100000, 8);
+    EXPECT_EQ(gedge(0, 7), q.pop());
+    EXPECT_EQ(gedge(100000, 8), q.pop());
+    EXPECT_TRUE(q.empty());
+}
+
+TEST(DialQueue, PushBelowTheLastPopIsCaught)
+{
+    dial_queue q;
+    q.push(5, 1);
+    EXPECT_EQ(gedge(5, 1), q.pop());
+    // asserts in a debug build, is clamped to 5 otherwise
+    EXPECT_DEBUG_DEATH({
+        q.push(3, 2);
+        EXPECT_EQ(gedge(5, 2), q.pop());
+    }, "");
+    EXPECT_DEBUG_DEATH(q.push(-7, 3), "");
+}
+
+TYPED_TEST(QueuePolicy, EarlyExitThenSmallerGraph)
+{
+    // the point-to-point search leaves entries queued for vertices that
+    // do not exist in the next graph
+    G_vvii big = random_graph(400, 2000, 5, 9);
+    G_vvii small = random_graph(20, 60, 6, 9);
+    shortest_path_algo reference;
+    basic_shortest_path_algo<TypeParam> algo;
+    algo.Dijkstra(big, 0, 1);
+    algo.Dijkstra(small, 0);
+    reference.Dijkstra(small, 0);
+    for (int v = 0; v < 20; ++v)
+        ASSERT_EQ(reference.distance(v), algo.distance(v)) << v;
+}
+
+// ---- point-to-point: bidirectional and A* ------------------------------------
+
+// side x side grid with unit spacing and weights 10..19, so 10 times the
+// straight-line distance is a consistent heuristic
+static G_vvii weighted_grid(int side, unsigned seed, std::vector<double> &x, std::vector<double> &y)
+{
+    G_vvii g = make_graph(side * side);
+    x.resize(side * side);
+    y.resize(side * side);
+    for (int r = 0; r < side; ++r)
+        for (int c = 0; c < side; ++c) {
+            int v = r * side + c;
+            x[v] = c;
+            y[v] = r;
+            int nb[] = {c + 1 < side ? v + 1 : -1, c > 0 ? v - 1 : -1, r + 1 < side ? v + side : -1, r > 0 ? v - side : -1};
+            for (int u : nb) {
+                if (u < 0) continue;
+                seed = seed * 1103515245u + 12345u;
+                add_edge(g, v, u, 10 + (int)((seed >> 8) % 10));
+            }
+        }
+    return g;
+}
+
+// Checks that the path printed for `to` runs from `from` over edges of g
+// and costs `expected`.
+template <class Algo>
+static void expect_path(const G_vvii &g, Algo &algo, int from, int to, int expected)
+{
+    std::vector<int> path = extract_path(capture_cout([&]{ algo.print_path(to); }));
+    ASSERT_FALSE(path.empty());
+    EXPECT_EQ(to, path.front());
+    EXPECT_EQ(from, path.back());
+    long long cost = 0;
+    for (std::size_t k = path.size() - 1; k > 0; --k) {
+        int best = -1;
+        for (const gedge &e : g[path[k]])
+            if (e.second == path[k - 1] && (best < 0 || e.first < best))
+                best = e.first;
+        ASSERT_GE(best, 0) << "no edge " << path[k] << " -> " << path[k - 1];
+        cost += best;
+    }
+    EXPECT_EQ(expected, cost);
+}
+
+TEST(CsrGraph, ReversedTurnsEveryEdge)
+{
+    G_vvii g = random_graph(50, 200, 9, 30);
+    csr_graph c, r;
+    ASSERT_EQ(0, c.build(g));
+    r = c.reversed();
+    ASSERT_EQ(50, r.vertex_count());
+    ASSERT_EQ(c.edge_count(), r.edge_count());
+    std::multiset<std::tuple<int, int, int> > forward, backward;
+    for (int v = 0; v < 50; ++v) {
+        for (std::size_t e = c.begin(v); e < c.end(v); ++e)
+            forward.insert(std::make_tuple(v, c.target(e), c.weight(e)));
+        for (std::size_t e = r.begin(v); e < r.end(v); ++e)
+            backward.insert(std::make_tuple(r.target(e), v, r.weight(e)));
+    }
+    EXPECT_EQ(forward, backward);
+}
+
+TEST(Bidirectional, StopsOnlyWhenNoShorterPathIsLeft)
+{
+    // both sides reach vertex 1 first, over a path of 6; the path of 5
+    // through 2 and 4 is found later
+    G_vvii g = make_graph(6);
+    add_edge(g, 0, 1, 3);
+    add_edge(g, 1, 5, 3);
+    add_edge(g, 0, 2, 2);
+    add_edge(g, 2, 4, 1);
+    add_edge(g, 4, 5, 2);
+    csr_graph c;
+    ASSERT_EQ(0, c.build(g));
+    shortest_path_algo algo;
+    ASSERT_EQ(0, algo.Dijkstra_bidirectional(c, c.reversed(), 0, 5));
+    EXPECT_EQ(5, algo.distance(5));
+    expect_path(g, algo, 0, 5, 5);
+}
+
+TEST(Bidirectional, ZeroWeightCycleAtTheMeetingPoint)
+{
+    G_vvii g = make_graph(4);
+    add_edge(g, 0, 1, 0);
+    add_edge(g, 1, 2, 0);
+    add_edge(g, 2, 1, 0);
+    add_edge(g, 1, 3, 5);
+    add_edge(g, 2, 3, 7);
+    csr_graph c;
+    ASSERT_EQ(0, c.build(g));
+    shortest_path_algo algo;
+    ASSERT_EQ(0, algo.Dijkstra_bidirectional(c, c.reversed(), 0, 3));
+    EXPECT_EQ(5, algo.distance(3));
+    expect_path(g, algo, 0, 3, 5);
+}
+
+TEST(Bidirectional, IgnoresDistancesOfEarlierSearches)
+{
+    // 0 -> 1 is too long to relax, so 1 is never stamped from 0, while
+    // the search from 2 left a distance of 5 in its slot
+    G_vvii g = make_graph(3);
+    add_edge(g, 0, 1, 999999999);
+    add_edge(g, 0, 2, 5);
+    add_edge(g, 2, 1, 5);
+    csr_graph c;
+    ASSERT_EQ(0, c.build(g));
+    shortest_path_algo algo;
+    algo.Dijkstra(c, 2);
+    ASSERT_EQ(5, algo.distance(1));
+    ASSERT_EQ(0, algo.Dijkstra_bidirectional(c, c.reversed(), 0, 1));
+    EXPECT_EQ(10, algo.distance(1));
+    expect_path(g, algo, 0, 1, 10);
+}
+
+TEST(Bidirectional, UnreachableAndTrivialTargets)
+{
+    G_vvii g = make_graph(3);
+    add_edge(g, 0, 1, 4);
+    csr_graph c;
+    ASSERT_EQ(0, c.build(g));
+    csr_graph r = c.reversed();
+    shortest_path_algo algo;
+    ASSERT_EQ(0, algo.Dijkstra_bidirectional(c, r, 0, 2));
+    EXPECT_EQ(987654321, algo.distance(2));
+    ASSERT_EQ(0, algo.Dijkstra_bidirectional(c, r, 1, 0));
+    EXPECT_EQ(987654321, algo.distance(0));
+    ASSERT_EQ(0, algo.Dijkstra_bidirectional(c, r, 1, 1));
+    EXPECT_EQ(0, algo.distance(1));
+    ASSERT_EQ(0, algo.Dijkstra_bidirectional(c, r, 0, 1));
+    EXPECT_EQ(4, algo.distance(1));
+}
+
+TEST(Bidirectional, RejectsBadArguments)
+{
+    G_vvii g = make_graph(3);
+    add_edge(g, 0, 1, 4);
+    csr_graph c, other;
+    ASSERT_EQ(0, c.build(g));
+    ASSERT_EQ(0, other.build(make_graph(4)));
+    shortest_path_algo algo;
+    std::ostringstream oss;
+    auto *olderr = std::cerr.rdbuf(oss.rdbuf());
+    EXPECT_EQ(-1, algo.Dijkstra_bidirectional(c, other, 0, 1));
+    EXPECT_EQ(-1, algo.Dijkstra_bidirectional(c, c.reversed(), 0, 3));
+    EXPECT_EQ(-1, algo.Dijkstra_bidirectional(c, c.reversed(), -1, 1));
+    EXPECT_EQ(-1, algo.Astar(c, 0, 3, [](int, int) { return 0; }));
+    EXPECT_EQ(-1, algo.Astar(g, 5, 1, [](int, int) { return 0; }));
+    std::cerr.rdbuf(olderr);
+}
+
+TEST(Astar, EuclideanHeuristicIsExactAndScansLess)
+{
+    std::vector<double> x, y;
+    G_vvii g = weighted_grid(60, 4, x, y);
+    csr_graph c;
+    ASSERT_EQ(0, c.build(g));
+    csr_graph r = c.reversed();
+    euclidean_heuristic h(x, y, 10.0);
+    shortest_path_algo dijkstra, astar, both;
+    long long scanned_dijkstra = 0, scanned_astar = 0, scanned_both = 0;
+    for (int k = 0; k < 20; ++k) {
+        int from = (k * 977) % 3600, to = (k * 1373 + 1800) % 3600;
+        dijkstra.Dijkstra(c, from, to);
+        astar.Astar(c, from, to, h);
+        both.Dijkstra_bidirectional(c, r, from, to);
+        ASSERT_EQ(dijkstra.distance(to), astar.distance(to)) << from << " -> " << to;
+        ASSERT_EQ(dijkstra.distance(to), both.distance(to)) << from << " -> " << to;
+        expect_path(g, astar, from, to, dijkstra.distance(to));
+        expect_path(g, both, from, to, dijkstra.distance(to));
+        scanned_dijkstra += dijkstra.scanned();
+        scanned_astar += astar.scanned();
+        scanned_both += both.scanned();
+    }
+    EXPECT_LT(scanned_astar * 2, scanned_dijkstra);
+    EXPECT_LT(scanned_both, scanned_dijkstra);
+}
+
+TYPED_TEST(QueuePolicy, PointToPointMatchesDijkstra)
+{
+    for (int maxw : {0, 1, 9, 1000}) {
+        G_vvii g = random_graph(300, 1200, 77 + maxw, maxw);
+        csr_graph c;
+        ASSERT_EQ(0, c.build(g));
+        csr_graph r = c.reversed();
+        shortest_path_algo reference;
+        basic_shortest_path_algo<TypeParam> both, astar;
+        for (int k = 0; k < 40; ++k) {
+            int from = (k * 37) % 300, to = (k * 101 + 5) % 300;
+            reference.Dijkstra(g, from);
+            ASSERT_EQ(0, both.Dijkstra_bidirectional(c, r, from, to));
+            ASSERT_EQ(reference.distance(to), both.distance(to)) << "maxw " << maxw << " " << from << " -> " << to;
+            ASSERT_EQ(0, astar.Astar(g, from, to, [](int, int) { return 0; }));
+            ASSERT_EQ(reference.distance(to), astar.distance(to)) << "maxw " << maxw << " " << from << " -> " << to;
+            if (reference.distance(to) != 987654321) {
+                expect_path(g, both, from, to, reference.distance(to));
+                expect_path(g, astar, from, to, reference.distance(to));
+            }
+        }
+    }
+    std::vector<double> x, y;
+    G_vvii grid = weighted_grid(30, 8, x, y);
+    shortest_path_algo reference;
+    basic_shortest_path_algo<TypeParam> astar;
+    euclidean_heuristic h(x, y, 10.0);
+    for (int k = 0; k < 20; ++k) {
+        int from = (k * 211) % 900, to = (k * 97 + 450) % 900;
+        reference.Dijkstra(grid, from, to);
+        ASSERT_EQ(0, astar.Astar(grid, from, to, h));
+        ASSERT_EQ(reference.distance(to), astar.distance(to)) << from << " -> " << to;
+    }
+}
+
+TYPED_TEST(QueuePolicy, AstarWithInconsistentHeuristic)
+{
+    // h(2) = 3 is admissible but not consistent: 1 is expanded at
+    // distance 3 before 2 is popped with key 4 and finds 1 at distance 2,
+    // which without pathmax would be pushed with key 2
+    G_vvii g = make_graph(4);
+    add_edge(g, 0, 1, 3);
+    add_edge(g, 0, 2, 1);
+    add_edge(g, 2, 1, 1);
+    add_edge(g, 1, 3, 2);
+    csr_graph c;
+    ASSERT_EQ(0, c.build(g));
+    basic_shortest_path_algo<TypeParam> astar;
+    ASSERT_EQ(0, astar.Astar(c, 0, 3, [](int v, int) { return v == 2 ? 3 : 0; }));
+    EXPECT_EQ(4, astar.distance(3));
+    expect_path(g, astar, 0, 3, 4);
+
+    // a random fraction of the exact distance to the target is admissible
+    // and almost never consistent
+    G_vvii big = random_graph(300, 1200, 5, 50);
+    csr_graph cb;
+    ASSERT_EQ(0, cb.build(big));
+    csr_graph rb = cb.reversed();
+    shortest_path_algo reference, to_target;
+    for (int k = 0; k < 40; ++k) {
+        int from = (k * 37) % 300, to = (k * 101 + 5) % 300;
+        reference.Dijkstra(cb, from);
+        to_target.Dijkstra(rb, to);
+        auto h = [&](int v, int) {
+            const int d = to_target.distance(v);
+            return d == 987654321 ? 0 : (int)((long long)d * ((v * 2654435761u + k) % 101) / 100);
+        };
+        ASSERT_EQ(0, astar.Astar(cb, from, to, h));
+        ASSERT_EQ(reference.distance(to), astar.distance(to)) << from << " -> " << to;
+        if (reference.distance(to) != 987654321)
+            expect_path(big, astar, from, to, reference.distance(to));
+    }
+}
@@ -0,0 +1,75 @@
+#include "commonlibs/arena.hpp"
+#include <gtest/gtest.h>
+
+struct pair_node { int a; int b; };
+
+TEST(ChunkArena, HandlesAreSequentialAndStable)
+{
+    commonlibs::chunk_arena<pair_node, 2> arena;   // 4 nodes per chunk
+    std::vector<commonlibs::chunk_arena<pair_node, 2>::handle_t> h;
+    for (int k = 0; k < 10; ++k) {
+        h.push_back(arena.allocate());
+        arena[h.back()].a = k;
+        arena[h.back()].b = -k;
+    }
+    EXPECT_EQ(10u, arena.size());
+    EXPECT_EQ(3u, arena.chunk_count());
+    EXPECT_EQ(3u * 4u * sizeof(pair_node), arena.bytes_reserved());
+    for (int k = 0; k < 10; ++k) {
+        EXPECT_EQ((unsigned)k, h[k]);
+        EXPECT_EQ(k, arena[h[k]].a);      // earlier chunks never move
+        EXPECT_EQ(-k, arena[h[k]].b);
+    }
+}
+
+TEST(ChunkArena, NewNodesAreValueInitialised)
+{
+    commonlibs::chunk_arena<pair_node, 3> arena;
+    auto h = arena.allocate();
+    EXPECT_EQ(0, arena[h].a);
+    EXPECT_EQ(0, arena[h].b);
+}
+
+TEST(ChunkArena, ClearAndSwap)
+{
+    commonlibs::chunk_arena<int, 4> a, b;
+    for (int k = 0; k < 40; ++k) a[a.allocate()] = k;
+    b[b.allocate()] = 7;
+
+    a.swap(b);
+    EXPECT_EQ(1u, a.size());
+    EXPECT_EQ(7, a[0]);
+    EXPECT_EQ(40u, b.size());
+    EXPECT_EQ(39, b[39]);
+
+    b.clear();
+    EXPECT_EQ(0u, b.size());
+    EXPECT_EQ(0u, b.chunk_count());
+    EXPECT_EQ(0u, b.allocate());
+}
+
+TEST(ChunkArena, MovedFromArenaStartsOver)
+{
+    commonlibs::chunk_arena<pair_node, 2> a;
+    for (int k = 0; k < 6; ++k)
+        a[a.allocate()].a = k;
+
+    commonlibs::chunk_arena<pair_node, 2> b(std::move(a));
+    EXPECT_EQ(6u, b.size());
+    EXPECT_EQ(5, b[5].a);
+    EXPECT_EQ(0u, a.size());
+    EXPECT_EQ(0u, a.chunk_count());
+    ASSERT_EQ(0u, a.allocate());
+    a[0].a = 42;
+    EXPECT_EQ(42, a[0].a);
+
+    commonlibs::chunk_arena<pair_node, 2> c;
+    c.allocate();
+    c = std::move(b);
+    EXPECT_EQ(6u, c.size());
+    EXPECT_EQ(3, c[3].a);
+    EXPECT_EQ(0u, b.size());
+    ASSERT_EQ(0u, b.allocate());
+    b[0].b = 7;
+    EXPECT_EQ(7, b[0].b);
+}
@@ -0,0 +1,136 @@
+#include "commonlibs/arena_trie.hpp"
+#include "commonlibs/prefix_tree.hpp"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static int countW(const commonlibs::arena_trie &t, const char *word)
+{
+    return t.countWords(word, std::strlen(word));
+}
+
+static int countP(const commonlibs::arena_trie &t, const char *prefix)
+{
+    return t.countPrefixes(prefix, std::strlen(prefix));
+}
+
+TEST(ArenaTrie, AddAndCountWords)
+{
+    commonlibs::arena_trie t;
+    t.addWord("hello", 5);
+    t.addWord("hello", 5);
+    t.addWord("help", 4);
+    EXPECT_EQ(2, countW(t, "hello"));
+    EXPECT_EQ(1, countW(t, "help"));
+    EXPECT_EQ(0, countW(t, "hel"));
+    EXPECT_EQ(0, countW(t, "world"));
+    EXPECT_EQ(2, countW(t, "HeLLo"));   // case is ignored
+}
+
+TEST(ArenaTrie, CountPrefixesIsDistinctFollowers)
+{
+    commonlibs::arena_trie t;
+    t.addWord("apple", 5);
+    t.addWord("apply", 5);
+    t.addWord("banana", 6);
+    EXPECT_EQ(2, t.countPrefixes("", 0));   // 'a' and 'b'
+    EXPECT_EQ(1, countP(t, "app"));         // only 'l'
+    EXPECT_EQ(2, countP(t, "appl"));        // 'e' and 'y'
+    EXPECT_EQ(0, countP(t, "apple"));
+    EXPECT_EQ(0, countP(t, "zebra"));
+}
+
+TEST(ArenaTrie, NonAlphaRejected)
+{
+    commonlibs::arena_trie t;
+    std::ostringstream oss;
+    auto *olderr = std::cerr.rdbuf(oss.rdbuf());
+    t.addWord("test123", 7);
+    EXPECT_EQ(0, countW(t, "test123"));
+    EXPECT_EQ(0, countP(t, "te5"));
+    std::cerr.rdbuf(olderr);
+    EXPECT_FALSE(oss.str().empty());
+    EXPECT_EQ(0, countW(t, "test"));    // the cut prefix is not a word
+    EXPECT_EQ(1, countP(t, "tes"));     // but its nodes exist, as in Vertex
+}
+
+TEST(ArenaTrie, EmptyAndNullWords)
+{
+    commonlibs::arena_trie t;
+    t.addWord("anything", 0);
+    t.addWord(nullptr, 0);
+    EXPECT_EQ(0, countW(t, "anything"));
+    EXPECT_EQ(1u, t.node_count());
+}
+
+TEST(ArenaTrie, ClearReleasesEverything)
+{
+    commonlibs::arena_trie t;
+    t.addWord("abc", 3);
+    t.addWord("abd", 3);
+    EXPECT_EQ(5u, t.node_count());
+    EXPECT_GT(t.bytes_reserved(), 0u);
+    t.clear();
+    EXPECT_EQ(1u, t.node_count());
+    EXPECT_EQ(0, countW(t, "abc"));
+    t.addWord("abc", 3);
+    EXPECT_EQ(1, countW(t, "abc"));
+}
+
+TEST(ArenaTrie, EmptyTrieIsSmall)
+{
+    commonlibs::arena_trie t;
+    EXPECT_EQ(1u, t.node_count());
+    EXPECT_LT(t.bytes_reserved(), 256u * 1024);
+}
+
+TEST(ArenaTrie, MovedFromTrieIsEmptyAndUsable)
+{
+    commonlibs::arena_trie a;
+    a.addWord("apple", 5);
+    a.addWord("apply", 5);
+
+    commonlibs::arena_trie b(std::move(a));
+    EXPECT_EQ(1, b.countWords("apple", 5));
+    EXPECT_EQ(1u, a.node_count());
+    EXPECT_EQ(0, a.countWords("apple", 5));
+    a.addWord("zoo", 3);
+    EXPECT_EQ(1, a.countWords("zoo", 3));
+
+    commonlibs::arena_trie c;
+    c.addWord("cat", 3);
+    c = std::move(b);
+    EXPECT_EQ(1, c.countWords("apply", 5));
+    EXPECT_EQ(0, c.countWords("cat", 3));
+    EXPECT_EQ(0, b.countPrefixes("", 0));
+    b.addWord("dog", 3);
+    EXPECT_EQ(1, b.countWords("dog", 3));
+}
+
+TEST(ArenaTrie, AgreesWithVertex)
+{
+    commonlibs::Vertex v;
+    commonlibs::arena_trie t;
+    std::vector<std::string> words;
+    unsigned seed = 5;
+    for (int k = 0; k < 3000; ++k) {
+        seed = seed * 1103515245u + 12345u;
+        int len = 1 + (int)((seed >> 16) % 7);
+        std::string w;
+        for (int c = 0; c < len; ++c) {
+            seed = seed * 1103515245u + 12345u;
+            w.push_back((char)('a' + (seed >> 16) % 5));
+        }
+        words.push_back(w);
+        v.addWord(w.c_str(), w.size());
+        t.addWord(w.c_str(), w.size());
+    }
+    for (const std::string &w : words) {
+        for (std::size_t len = 0; len <= w.size(); ++len) {
+            ASSERT_EQ(v.countWords(w.c_str(), len), t.countWords(w.c_str(), len)) << w.substr(0, len);
+            ASSERT_EQ(v.countPrefixes(w.c_str(), len), t.countPrefixes(w.c_str(), len)) << w.substr(0, len);
+        }
+    }
+}
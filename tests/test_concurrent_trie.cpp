@@ -0,0 +1,200 @@
+#include "commonlibs/concurrent_trie.hpp"
+#include "commonlibs/prefix_tree.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static int countW(const commonlibs::concurrent_trie &t, const std::string &w)
+{
+    return t.countWords(w.c_str(), w.size());
+}
+
+static int countP(const commonlibs::concurrent_trie &t, const std::string &w)
+{
+    return t.countPrefixes(w.c_str(), w.size());
+}
+
+static std::vector<std::string> random_words(int n, unsigned seed, int alphabet)
+{
+    std::vector<std::string> words;
+    for (int k = 0; k < n; ++k) {
+        seed = seed * 1103515245u + 12345u;
+        int len = 1 + (int)((seed >> 16) % 6);
+        std::string w;
+        for (int c = 0; c < len; ++c) {
+            seed = seed * 1103515245u + 12345u;
+            w.push_back((char)('a' + (seed >> 16) % alphabet));
+        }
+        words.push_back(w);
+    }
+    return words;
+}
+
+TEST(ConcurrentTrie, MatchesVertexSingleThreaded)
+{
+    commonlibs::Vertex v;
+    commonlibs::concurrent_trie t;
+    std::vector<std::string> words = random_words(3000, 12, 4);
+    for (const std::string &w : words) {
+        v.addWord(w.c_str(), w.size());
+        t.addWord(w.c_str(), w.size());
+    }
+    EXPECT_EQ(v.countPrefixes("", 0), t.countPrefixes("", 0));
+    for (const std::string &w : words)
+        for (std::size_t len = 1; len <= w.size(); ++len) {
+            ASSERT_EQ(v.countWords(w.c_str(), len), t.countWords(w.c_str(), len));
+            ASSERT_EQ(v.countPrefixes(w.c_str(), len), t.countPrefixes(w.c_str(), len));
+        }
+    std::ostringstream oss;
+    auto *olderr = std::cerr.rdbuf(oss.rdbuf());
+    EXPECT_EQ(0, t.addWord("ab1", 3));
+    EXPECT_EQ(0, countW(t, "ab1"));
+    EXPECT_EQ(0, countP(t, "a-"));
+    std::cerr.rdbuf(olderr);
+}
+
+TEST(ConcurrentTrie, RemoveWordPrunesEmptyNodes)
+{
+    commonlibs::concurrent_trie t;
+    EXPECT_EQ(1, t.addWord("car", 3));
+    EXPECT_EQ(2, t.addWord("car", 3));
+    t.addWord("cart", 4);
+    t.addWord("cat", 3);
+
+    EXPECT_EQ(-1, t.removeWord("ca", 2));     // never added
+    EXPECT_EQ(-1, t.removeWord("dog", 3));
+    EXPECT_EQ(1, t.removeWord("car", 3));
+    EXPECT_EQ(0, t.removeWord("car", 3));
+    EXPECT_EQ(-1, t.removeWord("car", 3));
+    EXPECT_EQ(0, countW(t, "car"));
+    EXPECT_EQ(1, countW(t, "cart"));          // "car" stays as a path
+    EXPECT_EQ(1, countP(t, "car"));
+
+    EXPECT_EQ(0, t.removeWord("cart", 4));    // prunes 't' and 'r'
+    EXPECT_EQ(0, countP(t, "car"));
+    EXPECT_EQ(1, countP(t, "ca"));            // only 't' of "cat" left
+    EXPECT_EQ(0, t.removeWord("cat", 3));     // prunes up to the root
+    EXPECT_EQ(0, countP(t, ""));
+
+    t.collect();
+    EXPECT_EQ(0u, t.pending_reclaim());
+    EXPECT_EQ(1, t.addWord("cart", 4));       // the path can be rebuilt
+    EXPECT_EQ(1, countP(t, "car"));
+}
+
+TEST(ConcurrentTrie, ConcurrentInsertersAndReaders)
+{
+    commonlibs::concurrent_trie t;
+    std::vector<std::string> words = random_words(2000, 99, 5);
+    const int writers = 4;
+    std::atomic<bool> done(false);
+    std::atomic<long> reads(0);
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; ++r)
+        readers.emplace_back([&]() {
+            long n = 0;
+            while (!done.load()) {
+                for (const std::string &w : words) {
+                    // counts only grow while nobody removes
+                    if (countW(t, w) < 0 || countP(t, w) < 0) ADD_FAILURE();
+                    ++n;
+                }
+            }
+            reads += n;
+        });
+    std::vector<std::thread> pool;
+    for (int id = 0; id < writers; ++id)
+        pool.emplace_back([&]() {
+            for (const std::string &w : words)
+                t.addWord(w.c_str(), w.size());
+        });
+    for (std::thread &th : pool) th.join();
+    done = true;
+    for (std::thread &th : readers) th.join();
+
+    commonlibs::Vertex v;
+    for (int id = 0; id < writers; ++id)
+        for (const std::string &w : words)
+            v.addWord(w.c_str(), w.size());
+    for (const std::string &w : words)
+        for (std::size_t len = 1; len <= w.size(); ++len) {
+            ASSERT_EQ(v.countWords(w.c_str(), len), t.countWords(w.c_str(), len)) << w.substr(0, len);
+            ASSERT_EQ(v.countPrefixes(w.c_str(), len), t.countPrefixes(w.c_str(), len)) << w.substr(0, len);
+        }
+    EXPECT_GT(reads.load(), 0);
+}
+
+struct counted {
+    std::atomic<int> *freed;
+    ~counted() { ++*freed; }
+};
+
+TEST(EpochDomain, MoreGuardsThanSlotsDoNotBlock)
+{
+    commonlibs::epoch_domain d;
+    std::atomic<int> freed(0);
+    {
+        // one thread holding them all would spin forever if guards waited
+        std::vector<std::unique_ptr<commonlibs::epoch_domain::guard> > guards;
+        for (int k = 0; k < commonlibs::epoch_domain::max_threads + 10; ++k)
+            guards.emplace_back(new commonlibs::epoch_domain::guard(d));
+        d.retire(new counted{&freed});
+        EXPECT_EQ(0u, d.collect());
+        // the slotted guards are gone, the overflow ones still hold it
+        guards.erase(guards.begin(), guards.begin() + commonlibs::epoch_domain::max_threads);
+        EXPECT_EQ(0u, d.collect());
+    }
+    EXPECT_EQ(1u, d.collect());
+    EXPECT_EQ(1, freed.load());
+    EXPECT_EQ(0u, d.pending());
+}
+
+TEST(ConcurrentTrie, ConcurrentAddAndRemove)
+{
+    commonlibs::concurrent_trie t;
+    std::vector<std::string> words = random_words(300, 7, 3);
+    const int rounds = 200;
+    std::atomic<long> removed(0);
+
+    std::thread adder([&]() {
+        for (int r = 0; r < rounds; ++r)
+            for (const std::string &w : words)
+                t.addWord(w.c_str(), w.size());
+    });
+    std::thread remover([&]() {
+        for (int r = 0; r < rounds; ++r)
+            for (const std::string &w : words)
+                if (t.removeWord(w.c_str(), w.size()) >= 0)
+                    ++removed;
+    });
+    std::thread reader([&]() {
+        for (int r = 0; r < rounds; ++r)
+            for (const std::string &w : words)
+                if (countW(t, w) < 0) ADD_FAILURE();
+    });
+    adder.join();
+    remover.join();
+    reader.join();
+
+    long left = 0;
+    std::vector<std::string> distinct(words);
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+    for (const std::string &w : distinct)
+        left += countW(t, w);
+    EXPECT_EQ((long)words.size() * rounds - removed.load(), left);
+
+    // drain: every node must come back out and be reclaimable
+    for (const std::string &w : distinct)
+        while (t.removeWord(w.c_str(), w.size()) > 0) {}
+    EXPECT_EQ(0, countP(t, ""));
+    t.collect();
+    EXPECT_EQ(0u, t.pending_reclaim());
+}
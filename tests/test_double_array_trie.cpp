@@ -0,0 +1,207 @@
+#include "commonlibs/double_array_trie.hpp"
+#include "commonlibs/prefix_tree.hpp"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::vector<std::string> random_words(int n, unsigned seed, int alphabet)
+{
+    std::vector<std::string> words;
+    for (int k = 0; k < n; ++k) {
+        seed = seed * 1103515245u + 12345u;
+        int len = 1 + (int)((seed >> 16) % 8);
+        std::string w;
+        for (int c = 0; c < len; ++c) {
+            seed = seed * 1103515245u + 12345u;
+            w.push_back((char)('a' + (seed >> 16) % alphabet));
+        }
+        words.push_back(w);
+    }
+    return words;
+}
+
+TEST(DoubleArrayTrie, EmptyTrie)
+{
+    commonlibs::double_array_trie empty;
+    EXPECT_EQ(0, empty.countWords("abc", 3));
+    EXPECT_EQ(0, empty.countPrefixes("", 0));
+
+    commonlibs::Vertex root;
+    commonlibs::double_array_trie t = commonlibs::double_array_trie::freeze(root);
+    EXPECT_EQ(1u, t.state_count());
+    EXPECT_EQ(0, t.countWords("a", 1));
+}
+
+TEST(DoubleArrayTrie, FrozenCountsMatchVertex)
+{
+    commonlibs::Vertex root;
+    const char *words[] = {"apple", "apply", "apt", "banana", "band", "apple"};
+    for (const char *w : words)
+        root.addWord(w, std::strlen(w));
+    commonlibs::double_array_trie t = commonlibs::double_array_trie::freeze(root);
+
+    EXPECT_EQ(2, t.countWords("apple", 5));
+    EXPECT_EQ(1, t.countWords("APT", 3));
+    EXPECT_EQ(0, t.countWords("app", 3));
+    EXPECT_EQ(0, t.countWords("bandana", 7));
+    EXPECT_EQ(2, t.countPrefixes("", 0));
+    EXPECT_EQ(2, t.countPrefixes("ap", 2));     // 'p' and 't'
+    EXPECT_EQ(2, t.countPrefixes("appl", 4));   // 'e' and 'y'
+    EXPECT_EQ(0, t.countPrefixes("zoo", 3));
+    EXPECT_GE(t.array_size(), t.state_count());
+}
+
+TEST(DoubleArrayTrie, NonAlphaLikeVertex)
+{
+    commonlibs::Vertex root;
+    root.addWord("abc", 3);
+    commonlibs::double_array_trie t = commonlibs::double_array_trie::freeze(root);
+    std::ostringstream oss;
+    auto *olderr = std::cerr.rdbuf(oss.rdbuf());
+    EXPECT_EQ(root.countWords("ab1", 3), t.countWords("ab1", 3));
+    EXPECT_EQ(root.countPrefixes("a-", 2), t.countPrefixes("a-", 2));
+    std::cerr.rdbuf(olderr);
+}
+
+TEST(DoubleArrayTrie, AgreesWithVertexOnRandomWords)
+{
+    for (int alphabet : {3, 26}) {
+        commonlibs::Vertex root;
+        std::vector<std::string> words = random_words(3000, 77 + alphabet, alphabet);
+        for (const std::string &w : words)
+            root.addWord(w.c_str(), w.size());
+        commonlibs::double_array_trie t = commonlibs::double_array_trie::freeze(root);
+        for (const std::string &w : words)
+            for (std::size_t len = 0; len <= w.size(); ++len) {
+                ASSERT_EQ(root.countWords(w.c_str(), len), t.countWords(w.c_str(), len)) << w.substr(0, len);
+                ASSERT_EQ(root.countPrefixes(w.c_str(), len), t.countPrefixes(w.c_str(), len)) << w.substr(0, len);
+            }
+        for (const std::string &w : random_words(2000, 5, 26))
+            ASSERT_EQ(root.countWords(w.c_str(), w.size()), t.countWords(w.c_str(), w.size())) << w;
+    }
+}
+
+TEST(DoubleArrayTrie, ConcurrentReaders)
+{
+    commonlibs::Vertex root;
+    std::vector<std::string> words = random_words(5000, 31, 26);
+    for (const std::string &w : words)
+        root.addWord(w.c_str(), w.size());
+    const commonlibs::double_array_trie t = commonlibs::double_array_trie::freeze(root);
+
+    std::vector<int> expect(words.size());
+    for (std::size_t k = 0; k < words.size(); ++k)
+        expect[k] = root.countWords(words[k].c_str(), words[k].size());
+
+    std::vector<int> mismatches(4, 0);
+    std::vector<std::thread> threads;
+    for (int id = 0; id < 4; ++id)
+        threads.emplace_back([&, id]() {
+            for (int round = 0; round < 20; ++round)
+                for (std::size_t k = id; k < words.size(); k += 4)
+                    if (t.countWords(words[k].c_str(), words[k].size()) != expect[k])
+                        ++mismatches[id];
+        });
+    for (std::thread &th : threads)
+        th.join();
+    for (int m : mismatches)
+        EXPECT_EQ(0, m);
+}
+
+// ---- trie files -------------------------------------------------------------
+
+#include <cstdio>
+#include <sys/wait.h>
+#include <unistd.h>
+
+TEST(MappedDoubleArrayTrie, SaveAndMapAgreesWithVertex)
+{
+    std::string path = testing::TempDir() + "cpptools_dat_file";
+    commonlibs::Vertex root;
+    std::vector<std::string> words = random_words(3000, 41, 26);
+    for (const std::string &w : words)
+        root.addWord(w.c_str(), w.size());
+    ASSERT_EQ(0, commonlibs::double_array_trie::freeze(root).save(path.c_str()));
+
+    commonlibs::mapped_double_array_trie m;
+    EXPECT_FALSE(m.is_open());
+    EXPECT_EQ(0, m.countWords("abc", 3));   // nothing open: empty trie
+    ASSERT_EQ(0, m.open(path.c_str()));
+    EXPECT_TRUE(m.is_open());
+    for (const std::string &w : words)
+        for (std::size_t len = 0; len <= w.size(); ++len) {
+            ASSERT_EQ(root.countWords(w.c_str(), len), m.countWords(w.c_str(), len)) << w.substr(0, len);
+            ASSERT_EQ(root.countPrefixes(w.c_str(), len), m.countPrefixes(w.c_str(), len)) << w.substr(0, len);
+        }
+    m.close();
+    EXPECT_EQ(0, m.countPrefixes("", 0));
+    std::remove(path.c_str());
+}
+
+TEST(MappedDoubleArrayTrie, SavingOverAnOpenFile)
+{
+    std::string path = testing::TempDir() + "cpptools_dat_resave";
+    commonlibs::Vertex big;
+    std::vector<std::string> words = random_words(20000, 43, 26);
+    for (const std::string &w : words)
+        big.addWord(w.c_str(), w.size());
+    ASSERT_EQ(0, commonlibs::double_array_trie::freeze(big).save(path.c_str()));
+    commonlibs::mapped_double_array_trie old_trie;
+    ASSERT_EQ(0, old_trie.open(path.c_str()));
+
+    // a much smaller trie: truncating in place would unmap most of the old
+    commonlibs::Vertex small;
+    small.addWord("new", 3);
+    ASSERT_EQ(0, commonlibs::double_array_trie::freeze(small).save(path.c_str()));
+    for (const std::string &w : words)
+        ASSERT_EQ(big.countWords(w.c_str(), w.size()), old_trie.countWords(w.c_str(), w.size())) << w;
+
+    commonlibs::mapped_double_array_trie m;
+    ASSERT_EQ(0, m.open(path.c_str()));
+    EXPECT_EQ(1, m.countWords("new", 3));
+    EXPECT_EQ(0, m.countWords(words[0].c_str(), words[0].size()));
+    std::remove(path.c_str());
+}
+
+TEST(MappedDoubleArrayTrie, RejectsBadFiles)
+{
+    commonlibs::mapped_double_array_trie m;
+    EXPECT_EQ(-1, m.open((testing::TempDir() + "cpptools_dat_missing").c_str()));
+
+    std::string junk = testing::TempDir() + "cpptools_dat_junk";
+    FILE *f = std::fopen(junk.c_str(), "wb");
+    ASSERT_TRUE(f != NULL);
+    std::fputs("not a trie file at all, just some text", f);
+    std::fclose(f);
+    EXPECT_EQ(-1, m.open(junk.c_str()));
+    EXPECT_FALSE(m.is_open());
+    std::remove(junk.c_str());
+}
+
+TEST(MappedDoubleArrayTrie, OtherProcessReadsSameFile)
+{
+    std::string path = testing::TempDir() + "cpptools_dat_fork";
+    commonlibs::Vertex root;
+    root.addWord("shared", 6);
+    root.addWord("shared", 6);
+    root.addWord("sharp", 5);
+    ASSERT_EQ(0, commonlibs::double_array_trie::freeze(root).save(path.c_str()));
+
+    pid_t pid = fork();
+    ASSERT_NE(-1, pid);
+    if (pid == 0) {
+        commonlibs::mapped_double_array_trie m;
+        if (m.open(path.c_str()) != 0) _exit(1);
+        if (m.countWords("shared", 6) != 2) _exit(2);
+        if (m.countPrefixes("shar", 4) != 2) _exit(3);
+        _exit(0);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(0, WEXITSTATUS(status));
+    std::remove(path.c_str());
+}
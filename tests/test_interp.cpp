@@ -189,3 +189,73 @@ TEST(SharedMemory, ClientOpenBeforeServer_Fails)
     named_shared_mem_client cli(const_cast<char*>("/cpptools_test_noserver"));
     EXPECT_NE(0, cli.open());
 }
+
+// ---------------------------------------------------------------------------
+// Memory-mapped files: the server creates the file, clients map it read only
+// ---------------------------------------------------------------------------
+
+TEST(MappedFile, ServerWritesClientReads)
+{
+    std::string path = testing::TempDir() + "cpptools_test_mapped_file";
+    {
+        named_mapped_file_server srv(path.c_str(), 4096);
+        ASSERT_EQ(0, srv.open());
+        EXPECT_EQ('\0', srv.get_address()[4095]);
+        std::strcpy(srv.get_address(), "on_disk");
+        ASSERT_EQ(0, srv.publish());
+    }
+    // the file outlives the server object
+    named_mapped_file_client cli(path.c_str());
+    ASSERT_EQ(0, cli.open());
+    EXPECT_STREQ("on_disk", cli.get_address());
+    EXPECT_EQ(static_cast<std::size_t>(4096), cli.get_size());
+    unlink(path.c_str());
+}
+
+TEST(MappedFile, ReplacingKeepsOldMappings)
+{
+    std::string path = testing::TempDir() + "cpptools_test_mapped_replace";
+    {
+        named_mapped_file_server srv(path.c_str(), 8192);
+        ASSERT_EQ(0, srv.open());
+        std::strcpy(srv.get_address() + 4096, "old");
+        ASSERT_EQ(0, srv.publish());
+    }
+    named_mapped_file_client old_cli(path.c_str());
+    ASSERT_EQ(0, old_cli.open());
+    {
+        // smaller, so an in-place truncate would cut off the old page
+        named_mapped_file_server srv(path.c_str(), 4096);
+        ASSERT_EQ(0, srv.open());
+        std::strcpy(srv.get_address(), "new");
+        // nothing is visible before publish()
+        named_mapped_file_client early(path.c_str());
+        ASSERT_EQ(0, early.open());
+        EXPECT_EQ(static_cast<std::size_t>(8192), early.get_size());
+        ASSERT_EQ(0, srv.publish());
+        EXPECT_NE(0, srv.publish());
+    }
+    EXPECT_STREQ("old", old_cli.get_address() + 4096);
+    named_mapped_file_client cli(path.c_str());
+    ASSERT_EQ(0, cli.open());
+    EXPECT_STREQ("new", cli.get_address());
+    unlink(path.c_str());
+}
+
+TEST(MappedFile, UnpublishedFileIsDropped)
+{
+    std::string path = testing::TempDir() + "cpptools_test_mapped_unpublished";
+    unlink(path.c_str());
+    {
+        named_mapped_file_server srv(path.c_str(), 4096);
+        ASSERT_EQ(0, srv.open());
+    }
+    EXPECT_NE(0, access(path.c_str(), F_OK));
+    EXPECT_NE(0, access((path + ".tmp").c_str(), F_OK));
+}
+
+TEST(MappedFile, ClientMissingFile_Fails)
+{
+    named_mapped_file_client cli("/nonexistent_dir_cpptools/file");
+    EXPECT_NE(0, cli.open());
+}
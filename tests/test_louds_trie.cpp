@@ -0,0 +1,150 @@
+#include "commonlibs/louds_trie.hpp"
+#include "commonlibs/prefix_tree.hpp"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static std::vector<std::string> random_words(int n, unsigned seed, int alphabet)
+{
+    std::vector<std::string> words;
+    for (int k = 0; k < n; ++k) {
+        seed = seed * 1103515245u + 12345u;
+        int len = 1 + (int)((seed >> 16) % 8);
+        std::string w;
+        for (int c = 0; c < len; ++c) {
+            seed = seed * 1103515245u + 12345u;
+            w.push_back((char)('a' + (seed >> 16) % alphabet));
+        }
+        words.push_back(w);
+    }
+    return words;
+}
+
+// ---- rank_select_bitvector --------------------------------------------------
+
+static void check_against_naive(const std::vector<bool> &bits)
+{
+    commonlibs::rank_select_bitvector bv;
+    for (bool b : bits)
+        bv.push_back(b);
+    bv.build();
+    ASSERT_EQ(bits.size(), bv.size());
+    std::vector<std::size_t> ones, zeros;
+    std::size_t r = 0;
+    for (std::size_t i = 0; i <= bits.size(); ++i) {
+        ASSERT_EQ(r, bv.rank1(i)) << i;
+        ASSERT_EQ(i - r, bv.rank0(i)) << i;
+        if (i == bits.size())
+            break;
+        ASSERT_EQ(bits[i], bv[i]) << i;
+        (bits[i] ? ones : zeros).push_back(i);
+        r += bits[i];
+    }
+    EXPECT_EQ(ones.size(), bv.ones());
+    for (std::size_t k = 0; k < ones.size(); ++k)
+        ASSERT_EQ(ones[k], bv.select1(k)) << k;
+    for (std::size_t k = 0; k < zeros.size(); ++k)
+        ASSERT_EQ(zeros[k], bv.select0(k)) << k;
+    EXPECT_EQ(bits.size(), bv.select1(ones.size()));
+    EXPECT_EQ(bits.size(), bv.select0(zeros.size()));
+    for (std::size_t i = 0; i < bits.size(); i += 7) {
+        std::size_t z = i;
+        while (z < bits.size() && bits[z]) ++z;
+        ASSERT_EQ(z, bv.next_zero(i)) << i;
+    }
+}
+
+TEST(RankSelectBitvector, EmptyAndTiny)
+{
+    check_against_naive({});
+    check_against_naive({true});
+    check_against_naive({false});
+    check_against_naive({true, false, true, true, false});
+}
+
+TEST(RankSelectBitvector, BlockBoundaries)
+{
+    for (std::size_t n : {63u, 64u, 65u, 449u, 511u, 512u, 513u, 1024u, 1537u}) {
+        check_against_naive(std::vector<bool>(n, true));
+        check_against_naive(std::vector<bool>(n, false));
+        std::vector<bool> alt(n);
+        for (std::size_t i = 0; i < n; ++i) alt[i] = i % 3 == 0;
+        check_against_naive(alt);
+    }
+}
+
+TEST(RankSelectBitvector, RandomDensities)
+{
+    unsigned seed = 3;
+    for (unsigned per_mille : {5u, 100u, 500u, 900u, 995u}) {
+        std::vector<bool> bits(20000 + per_mille);
+        for (std::size_t i = 0; i < bits.size(); ++i) {
+            seed = seed * 1103515245u + 12345u;
+            bits[i] = (seed >> 16) % 1000 < per_mille;
+        }
+        check_against_naive(bits);
+    }
+}
+
+// ---- louds_trie -------------------------------------------------------------
+
+TEST(LoudsTrie, EmptyTrie)
+{
+    commonlibs::louds_trie empty;
+    EXPECT_EQ(0, empty.countWords("abc", 3));
+    EXPECT_EQ(0, empty.countPrefixes("", 0));
+    EXPECT_EQ(1u, empty.node_count());
+
+    commonlibs::Vertex root;
+    commonlibs::louds_trie t = commonlibs::louds_trie::freeze(root);
+    EXPECT_EQ(1u, t.node_count());
+    EXPECT_EQ(0, t.countWords("a", 1));
+    EXPECT_EQ(0, t.countPrefixes("a", 1));
+}
+
+TEST(LoudsTrie, FrozenCountsMatchVertex)
+{
+    commonlibs::Vertex root;
+    const char *words[] = {"apple", "apply", "apt", "banana", "band", "apple", "b"};
+    for (const char *w : words)
+        root.addWord(w, std::strlen(w));
+    commonlibs::louds_trie t = commonlibs::louds_trie::freeze(root);
+
+    EXPECT_EQ(2, t.countWords("apple", 5));
+    EXPECT_EQ(1, t.countWords("APT", 3));
+    EXPECT_EQ(1, t.countWords("b", 1));
+    EXPECT_EQ(0, t.countWords("app", 3));
+    EXPECT_EQ(0, t.countWords("bandana", 7));
+    EXPECT_EQ(2, t.countPrefixes("", 0));
+    EXPECT_EQ(2, t.countPrefixes("ap", 2));
+    EXPECT_EQ(2, t.countPrefixes("appl", 4));
+    EXPECT_EQ(0, t.countPrefixes("zoo", 3));
+
+    std::ostringstream oss;
+    auto *olderr = std::cerr.rdbuf(oss.rdbuf());
+    EXPECT_EQ(root.countWords("ab1", 3), t.countWords("ab1", 3));
+    EXPECT_EQ(root.countPrefixes("a-", 2), t.countPrefixes("a-", 2));
+    std::cerr.rdbuf(olderr);
+}
+
+TEST(LoudsTrie, AgreesWithVertexOnRandomWords)
+{
+    for (int alphabet : {2, 5, 26}) {
+        commonlibs::Vertex root;
+        std::vector<std::string> words = random_words(4000, 91 + alphabet, alphabet);
+        for (const std::string &w : words)
+            root.addWord(w.c_str(), w.size());
+        commonlibs::louds_trie t = commonlibs::louds_trie::freeze(root);
+        for (const std::string &w : words)
+            for (std::size_t len = 0; len <= w.size(); ++len) {
+                ASSERT_EQ(root.countWords(w.c_str(), len), t.countWords(w.c_str(), len)) << w.substr(0, len);
+                ASSERT_EQ(root.countPrefixes(w.c_str(), len), t.countPrefixes(w.c_str(), len)) << w.substr(0, len);
+            }
+        for (const std::string &w : random_words(2000, 6, 26))
+            ASSERT_EQ(root.countWords(w.c_str(), w.size()), t.countWords(w.c_str(), w.size())) << w;
+        // a few bits and a label byte per node
+        EXPECT_LT(t.bytes(), t.node_count() * 8);
+    }
+}
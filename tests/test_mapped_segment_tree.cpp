@@ -0,0 +1,168 @@
+#include "commonlibs/mapped_segment_tree.hpp"
+#include "commonlibs/segment_tree.hpp"
+#include <gtest/gtest.h>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static std::string temp_path(const char *name)
+{
+    return testing::TempDir() + name;
+}
+
+TEST(MappedSegmentTree, BuildAndReopen)
+{
+    std::string path = temp_path("cpptools_mst_basic");
+    int a[] = {4, 2, 7, 1, 8, 3};
+    ASSERT_EQ(0, commonlibs::mapped_segments_tree<>::build(path.c_str(), a, 6));
+
+    commonlibs::mapped_segments_tree<> t;
+    ASSERT_EQ(0, t.open(path.c_str()));
+    EXPECT_TRUE(t.is_open());
+    EXPECT_EQ(6, t.size());
+    EXPECT_EQ(3, t.query(0, 5));
+    EXPECT_EQ(1, t.query(0, 2));
+    EXPECT_EQ(5, t.query(4, 5));
+    EXPECT_EQ(7, t.value(2));
+    std::remove(path.c_str());
+}
+
+TEST(MappedSegmentTree, OutOfRangeAndClosed)
+{
+    std::string path = temp_path("cpptools_mst_range");
+    int a[] = {1, 2, 3};
+    ASSERT_EQ(0, commonlibs::mapped_segments_tree<>::build(path.c_str(), a, 3));
+
+    commonlibs::mapped_segments_tree<> t;
+    EXPECT_EQ(-1, t.query(0, 2));   // nothing open yet
+    ASSERT_EQ(0, t.open(path.c_str()));
+    EXPECT_EQ(-1, t.query(3, 5));
+    EXPECT_EQ(-1, t.query(2, 1));
+    EXPECT_EQ(0, t.query(-5, 10));
+    t.close();
+    EXPECT_FALSE(t.is_open());
+    EXPECT_EQ(0, t.size());
+    std::remove(path.c_str());
+}
+
+TEST(MappedSegmentTree, RebuildLeavesOpenTreesWorking)
+{
+    std::string path = temp_path("cpptools_mst_rebuild");
+    std::vector<int> big(100000);
+    for (int k = 0; k < (int)big.size(); ++k)
+        big[k] = 100000 - k;
+    ASSERT_EQ(0, commonlibs::mapped_segments_tree<>::build(path.c_str(), big.data(), (long long)big.size()));
+    commonlibs::mapped_segments_tree<> old_tree;
+    ASSERT_EQ(0, old_tree.open(path.c_str()));
+
+    int a[] = {5, 3, 9};
+    ASSERT_EQ(0, commonlibs::mapped_segments_tree<>::build(path.c_str(), a, 3));
+    // the old tree still reads its own pages, past the end of the new file
+    EXPECT_EQ(99999, old_tree.query(0, 99999));
+    EXPECT_EQ(1, old_tree.value(99999));
+    commonlibs::mapped_segments_tree<> t;
+    ASSERT_EQ(0, t.open(path.c_str()));
+    EXPECT_EQ(3, t.size());
+    EXPECT_EQ(1, t.query(0, 2));
+    std::remove(path.c_str());
+}
+
+TEST(MappedSegmentTree, RejectsBadFiles)
+{
+    commonlibs::mapped_segments_tree<> t;
+    EXPECT_EQ(-1, t.open(temp_path("cpptools_mst_missing").c_str()));
+
+    std::string junk = temp_path("cpptools_mst_junk");
+    FILE *f = std::fopen(junk.c_str(), "wb");
+    ASSERT_TRUE(f != NULL);
+    std::vector<char> bytes(8192, 'x');
+    std::fwrite(bytes.data(), 1, bytes.size(), f);
+    std::fclose(f);
+    EXPECT_EQ(-1, t.open(junk.c_str()));
+    EXPECT_FALSE(t.is_open());
+    std::remove(junk.c_str());
+
+    // built with another block width
+    std::string path = temp_path("cpptools_mst_b16");
+    int a[] = {5, 1, 4};
+    ASSERT_EQ(0, commonlibs::mapped_segments_tree<16>::build(path.c_str(), a, 3));
+    EXPECT_EQ(-1, t.open(path.c_str()));
+    commonlibs::mapped_segments_tree<16> t16;
+    EXPECT_EQ(0, t16.open(path.c_str()));
+    EXPECT_EQ(1, t16.query(0, 2));
+    std::remove(path.c_str());
+
+    EXPECT_EQ(-1, commonlibs::mapped_segments_tree<>::build(path.c_str(), a, 0));
+}
+
+// overwrites the 8 bytes at offset in the file at path
+static void patch(const std::string &path, long offset, uint64_t v)
+{
+    FILE *f = std::fopen(path.c_str(), "r+b");
+    ASSERT_TRUE(f != NULL);
+    std::fseek(f, offset, SEEK_SET);
+    std::fwrite(&v, sizeof(v), 1, f);
+    std::fclose(f);
+}
+
+TEST(MappedSegmentTree, RejectsDamagedHeaders)
+{
+    // header: magic[8], block_keys, height, array_size @16,
+    // total_blocks @24, level_offset[] @32
+    std::string path = temp_path("cpptools_mst_damaged");
+    std::vector<int> a(1000, 3);
+    struct { long offset; uint64_t value; } damage[] = {
+        {16, 1000000},                 // array_size past level 0
+        {16, 0},                       // empty array
+        {24, 0x2000000000000001ULL},   // total_blocks * B * 8 overflows
+        {32, 1ULL << 40},              // level 0 far outside the file
+        {32 + 8, 200},                 // level 1 overlapping level 0
+    };
+    for (const auto &d : damage) {
+        ASSERT_EQ(0, commonlibs::mapped_segments_tree<>::build(path.c_str(), a.data(), (long long)a.size()));
+        patch(path, d.offset, d.value);
+        commonlibs::mapped_segments_tree<> t;
+        EXPECT_EQ(-1, t.open(path.c_str())) << "offset " << d.offset;
+        EXPECT_FALSE(t.is_open());
+    }
+    std::remove(path.c_str());
+}
+
+TEST(MappedSegmentTree, ValueOutOfRange)
+{
+    std::string path = temp_path("cpptools_mst_value");
+    int a[] = {4, 2, 7};
+    ASSERT_EQ(0, commonlibs::mapped_segments_tree<>::build(path.c_str(), a, 3));
+    commonlibs::mapped_segments_tree<> t;
+    EXPECT_EQ(INT_MAX, t.value(0));   // nothing open yet
+    ASSERT_EQ(0, t.open(path.c_str()));
+    EXPECT_EQ(4, t.value(0));
+    EXPECT_EQ(INT_MAX, t.value(-1));
+    EXPECT_EQ(INT_MAX, t.value(3));
+    std::remove(path.c_str());
+}
+
+TEST(MappedSegmentTree, AgreesWithSegmentsTree)
+{
+    std::string path = temp_path("cpptools_mst_random");
+    for (int n = 1; n <= 600; n += 67) {
+        std::vector<int> a(n);
+        unsigned seed = 17 + n;
+        for (int k = 0; k < n; ++k) {
+            seed = seed * 1103515245u + 12345u;
+            a[k] = (int)((seed >> 16) % 40) - 20;
+        }
+        a[n / 2] = INT_MIN;
+        ASSERT_EQ(0, commonlibs::mapped_segments_tree<>::build(path.c_str(), a.data(), n));
+        commonlibs::mapped_segments_tree<> mapped;
+        ASSERT_EQ(0, mapped.open(path.c_str()));
+        commonlibs::segments_tree seg(a.data(), n);
+        seg.initialize(0, 0, n - 1);
+        for (int i = 0; i < n; i += 3)
+            for (int j = i; j < n; j += 5)
+                ASSERT_EQ(seg.query(0, i, j), mapped.query(i, j)) << "n=" << n << " [" << i << "," << j << "]";
+    }
+    std::remove(path.c_str());
+}
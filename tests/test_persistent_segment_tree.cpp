@@ -0,0 +1,108 @@
+#include "commonlibs/persistent_segment_tree.hpp"
+#include <gtest/gtest.h>
+#include <sstream>
+#include <vector>
+
+using commonlibs::persistent_segments_tree;
+
+TEST(PersistentSegmentTree, Version0MatchesArray)
+{
+    int a[] = {4, 2, 7, 1, 8, 3};
+    persistent_segments_tree t(a, 6);
+    t.initialize(0, 0, 5);
+    EXPECT_EQ(0, t.latest_version());
+    EXPECT_EQ(3, t.query(0, 0, 5));
+    EXPECT_EQ(1, t.query(0, 0, 2));
+    EXPECT_EQ(5, t.query(0, 4, 5));
+    EXPECT_EQ(-1, t.query(0, 6, 9));
+    EXPECT_EQ(-1, t.query(1, 0, 5));    // no such version yet
+}
+
+TEST(PersistentSegmentTree, OldVersionsStayQueryable)
+{
+    int a[] = {5, 3, 1, 4, 9};
+    persistent_segments_tree t(a, 5);
+    t.initialize();
+
+    EXPECT_EQ(1, t.update(2, 10));      // v1: {5, 3, 10, 4, 9}
+    EXPECT_EQ(2, t.update(0, 0));       // v2: {0, 3, 10, 4, 9}
+    EXPECT_EQ(3, t.update(0, 6));       // v3: {6, 3, 10, 4, 9}
+
+    EXPECT_EQ(2, t.query(0, 0, 4));
+    EXPECT_EQ(1, t.query(1, 0, 4));
+    EXPECT_EQ(0, t.query(2, 0, 4));
+    EXPECT_EQ(1, t.query(3, 0, 4));
+    EXPECT_EQ(1, t.value(0, 2));
+    EXPECT_EQ(10, t.value(3, 2));
+    EXPECT_EQ(0, t.value(2, 0));
+}
+
+TEST(PersistentSegmentTree, UpdateCopiesOnlyOnePath)
+{
+    std::vector<int> a(1024, 7);
+    persistent_segments_tree t(a.data(), 1024);
+    t.initialize();
+    std::size_t base = t.node_count();
+    EXPECT_EQ(2047u, base);
+    t.update(100, 1);
+    EXPECT_EQ(base + 11, t.node_count());   // root-to-leaf path of a 1024-leaf tree
+}
+
+TEST(PersistentSegmentTree, DropVersionsCompactsArena)
+{
+    std::vector<int> a(4096);
+    for (int k = 0; k < 4096; ++k) a[k] = k;
+    persistent_segments_tree t(a.data(), 4096);
+    t.initialize();
+    for (int u = 0; u < 2000; ++u)
+        t.update((u * 37) % 4096, -u);
+    std::size_t before = t.node_count();
+
+    EXPECT_EQ(0, t.drop_versions_before(1990));
+    EXPECT_EQ(1990, t.oldest_version());
+    EXPECT_EQ(2000, t.latest_version());
+    EXPECT_LT(t.node_count(), before);
+    EXPECT_FALSE(t.has_version(1989));
+    EXPECT_EQ(-1, t.query(5, 0, 4095));
+
+    // retained versions answer exactly as before the drop
+    EXPECT_EQ((1999 * 37) % 4096, t.query(2000, 0, 4095));
+    EXPECT_EQ((1989 * 37) % 4096, t.query(1990, 0, 4095));
+    EXPECT_EQ(-1989, t.value(1990, (1989 * 37) % 4096));
+
+    std::ostringstream oss;
+    auto *olderr = std::cerr.rdbuf(oss.rdbuf());
+    EXPECT_EQ(-1, t.drop_versions_before(5));
+    std::cerr.rdbuf(olderr);
+}
+
+TEST(PersistentSegmentTree, EveryVersionMatchesBruteForce)
+{
+    const int n = 23;
+    std::vector<int> cur(n);
+    unsigned seed = 31337;
+    auto rnd = [&seed]() { seed = seed * 1103515245u + 12345u; return (int)((seed >> 16) % 40); };
+    for (int k = 0; k < n; ++k) cur[k] = rnd();
+
+    persistent_segments_tree t(cur.data(), n);
+    t.initialize();
+    std::vector<std::vector<int> > history(1, cur);
+    for (int u = 0; u < 60; ++u) {
+        int i = rnd() % n;
+        cur[i] = rnd();
+        ASSERT_EQ(u + 1, t.update(i, cur[i]));
+        history.push_back(cur);
+    }
+    t.drop_versions_before(10);
+    for (int v = 10; v <= 60; ++v) {
+        const std::vector<int> &h = history[v];
+        for (int i = 0; i < n; ++i) {
+            for (int j = i; j < n; ++j) {
+                int expect = i;
+                for (int k = i; k <= j; ++k)
+                    if (h[k] < h[expect]) expect = k;
+                ASSERT_EQ(expect, t.query(v, i, j)) << "v=" << v << " [" << i << "," << j << "]";
+            }
+        }
+    }
+}
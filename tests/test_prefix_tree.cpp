@@ -1,7 +1,11 @@
 #include "commonlibs/prefix_tree.hpp"
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <cstring>
+#include <map>
 #include <sstream>
+#include <string>
+#include <vector>
 
 // Helper: add a word to a root Vertex
 static void add(commonlibs::Vertex &root, const char *word)
@@ -222,3 +226,373 @@ TEST(PrefixTree, ManyWordsWithCommonPrefix)
     // "aa" is a prefix of all 26 words
     EXPECT_GT(root.countPrefixes("aa", 2), 0);
 }
+
+// ---- build_from_sorted ------------------------------------------------------
+
+static std::vector<std::string> random_words(int n, unsigned seed)
+{
+    std::vector<std::string> words;
+    for (int k = 0; k < n; ++k) {
+        seed = seed * 1103515245u + 12345u;
+        int len = 1 + (int)((seed >> 16) % 8);
+        std::string w;
+        for (int c = 0; c < len; ++c) {
+            seed = seed * 1103515245u + 12345u;
+            w.push_back((char)('a' + (seed >> 16) % 6 + (c == 0 ? (seed >> 8) % 20 : 0)));
+        }
+        words.push_back(w);
+    }
+    return words;
+}
+
+static void expect_same_counts(commonlibs::Vertex &a, commonlibs::Vertex &b, const std::vector<std::string> &words)
+{
+    EXPECT_EQ(a.countPrefixes("", 0), b.countPrefixes("", 0));
+    for (const std::string &w : words)
+        for (std::size_t len = 1; len <= w.size(); ++len) {
+            ASSERT_EQ(a.countWords(w.c_str(), len), b.countWords(w.c_str(), len)) << w.substr(0, len);
+            ASSERT_EQ(a.countPrefixes(w.c_str(), len), b.countPrefixes(w.c_str(), len)) << w.substr(0, len);
+        }
+}
+
+TEST(PrefixTree, BuildFromSortedMatchesAddWord)
+{
+    std::vector<std::string> words = random_words(4000, 3);
+    std::sort(words.begin(), words.end());
+    for (unsigned threads : {1u, 4u}) {
+        commonlibs::Vertex incremental, bulk;
+        for (const std::string &w : words)
+            incremental.addWord(w.c_str(), w.size());
+        EXPECT_EQ((int)words.size(), bulk.build_from_sorted(words.begin(), words.end(), threads));
+        expect_same_counts(incremental, bulk, words);
+    }
+}
+
+TEST(PrefixTree, BuildFromSortedUnsortedAndExistingWords)
+{
+    std::vector<std::string> words = random_words(1500, 8);   // not sorted
+    commonlibs::Vertex incremental, bulk;
+    incremental.addWord("seed", 4);
+    bulk.addWord("seed", 4);
+    for (const std::string &w : words)
+        incremental.addWord(w.c_str(), w.size());
+    bulk.build_from_sorted(words.begin(), words.end());
+    expect_same_counts(incremental, bulk, words);
+    EXPECT_EQ(1, countW(bulk, "seed"));
+}
+
+TEST(PrefixTree, BuildFromSortedCaseAndInvalidWords)
+{
+    std::vector<std::string> words = {"", "1abc", "Apple", "apple", "apPly", "ban4na", "band"};
+    commonlibs::Vertex incremental, bulk;
+    std::ostringstream oss;
+    auto *olderr = std::cerr.rdbuf(oss.rdbuf());
+    for (const std::string &w : words)
+        incremental.addWord(w.c_str(), w.size());
+    int added = bulk.build_from_sorted(words.begin(), words.end(), 2);
+    std::cerr.rdbuf(olderr);
+
+    EXPECT_EQ(4, added);   // "", "1abc" and "ban4na" are not words
+    EXPECT_EQ(2, countW(bulk, "apple"));
+    EXPECT_EQ(0, countW(bulk, "ban"));
+    EXPECT_EQ(1, countP(bulk, "ban"));   // "ban4na" leaves the nodes up to "ban"
+    expect_same_counts(incremental, bulk, {"apple", "apply", "band", "banna"});
+}
+
+// ---- word_iterator ----------------------------------------------------------
+
+TEST(PrefixTree, WordIteratorEmptyTrie)
+{
+    commonlibs::Vertex root;
+    EXPECT_TRUE(commonlibs::word_iterator(&root) == commonlibs::word_iterator());
+    EXPECT_TRUE(commonlibs::word_iterator(&root, "abc", 3) == commonlibs::word_iterator());
+}
+
+TEST(PrefixTree, WordIteratorAlphabeticalWithCounts)
+{
+    commonlibs::Vertex root;
+    add(root, "band");
+    add(root, "Apple");
+    add(root, "apple");
+    add(root, "ban");
+    add(root, "apply");
+    add(root, "b");
+    std::vector<std::pair<std::string, int> > got((commonlibs::word_iterator(&root)), commonlibs::word_iterator());
+    std::vector<std::pair<std::string, int> > want = {
+        {"apple", 2}, {"apply", 1}, {"b", 1}, {"ban", 1}, {"band", 1}};
+    EXPECT_EQ(want, got);
+}
+
+TEST(PrefixTree, WordIteratorPrefix)
+{
+    commonlibs::Vertex root;
+    add(root, "car");
+    add(root, "cart");
+    add(root, "cat");
+    add(root, "dog");
+    std::vector<std::string> got;
+    for (commonlibs::word_iterator it(&root, "CA", 2), end; it != end; ++it)
+        got.push_back(it->first);
+    EXPECT_EQ((std::vector<std::string>{"car", "cart", "cat"}), got);
+
+    commonlibs::word_iterator it(&root, "cart", 4);   // the prefix itself is a word
+    ASSERT_TRUE(it != commonlibs::word_iterator());
+    EXPECT_EQ("cart", (it++)->first);
+    EXPECT_TRUE(it == commonlibs::word_iterator());
+    EXPECT_TRUE(commonlibs::word_iterator(&root, "cow", 3) == commonlibs::word_iterator());
+
+    std::ostringstream oss;
+    auto *olderr = std::cerr.rdbuf(oss.rdbuf());
+    EXPECT_TRUE(commonlibs::word_iterator(&root, "c4", 2) == commonlibs::word_iterator());
+    std::cerr.rdbuf(olderr);
+}
+
+TEST(PrefixTree, WordIteratorMatchesSortedCounts)
+{
+    std::vector<std::string> words = random_words(3000, 21);
+    commonlibs::Vertex root;
+    std::map<std::string, int> ref;
+    for (const std::string &w : words) {
+        root.addWord(w.c_str(), w.size());
+        ++ref[w];
+    }
+    std::map<std::string, int>::const_iterator r = ref.begin();
+    for (commonlibs::word_iterator it(&root), end; it != end; ++it, ++r) {
+        ASSERT_TRUE(r != ref.end());
+        ASSERT_EQ(r->first, it->first);
+        ASSERT_EQ(r->second, it->second);
+    }
+    EXPECT_TRUE(r == ref.end());
+}
+
+// ---- aho_corasick -----------------------------------------------------------
+
+typedef std::vector<std::pair<uint64_t, std::string> > match_list;
+
+static match_list scan(commonlibs::aho_corasick &ac, const std::string &text, std::size_t chunk)
+{
+    match_list found;
+    for (std::size_t k = 0; k < text.size(); k += chunk) {
+        std::size_t n = std::min(chunk, text.size() - k);
+        ac.feed(text.data() + k, n, [&](uint64_t end, int id) {
+            found.push_back(std::make_pair(end, ac.pattern(id)));
+        });
+    }
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+// reference: every (end, word) with the word occurring in text
+static match_list brute_force_matches(const std::vector<std::string> &words, std::string text)
+{
+    for (char &ch : text)
+        ch = ::isalpha((unsigned char)ch) ? (char)::tolower((unsigned char)ch) : '#';
+    std::vector<std::string> distinct(words);
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+    match_list found;
+    for (const std::string &w : distinct)
+        for (std::size_t pos = text.find(w); pos != std::string::npos; pos = text.find(w, pos + 1))
+            found.push_back(std::make_pair((uint64_t)(pos + w.size()), w));
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+TEST(AhoCorasick, ClassicExample)
+{
+    commonlibs::Vertex root;
+    for (const char *w : {"he", "she", "his", "hers"})
+        add(root, w);
+    commonlibs::aho_corasick ac = commonlibs::aho_corasick::compile(root);
+    EXPECT_EQ(4u, ac.pattern_count());
+    match_list want = {{4, "he"}, {4, "she"}, {6, "hers"}};
+    EXPECT_EQ(want, scan(ac, "ushers", 6));
+    EXPECT_EQ(6u, ac.stream_position());
+}
+
+TEST(AhoCorasick, EmptyAutomatonMatchesNothing)
+{
+    commonlibs::aho_corasick none;
+    EXPECT_TRUE(scan(none, "anything at all", 4).empty());
+    commonlibs::Vertex root;
+    commonlibs::aho_corasick ac = commonlibs::aho_corasick::compile(root);
+    EXPECT_EQ(1u, ac.state_count());
+    EXPECT_TRUE(scan(ac, "text", 1).empty());
+}
+
+TEST(AhoCorasick, CaseSeparatorsAndDuplicates)
+{
+    commonlibs::Vertex root;
+    add(root, "error");
+    add(root, "error");      // counted twice in the trie, reported once
+    add(root, "or");
+    commonlibs::aho_corasick ac = commonlibs::aho_corasick::compile(root);
+    match_list want = {{5, "error"}, {5, "or"}, {13, "or"}};
+    EXPECT_EQ(want, scan(ac, "ERRor: err-or", 100));
+}
+
+TEST(AhoCorasick, MatchesAcrossChunkBoundaries)
+{
+    commonlibs::Vertex root;
+    add(root, "timeout");
+    add(root, "out");
+    commonlibs::aho_corasick ac = commonlibs::aho_corasick::compile(root);
+    std::size_t n = 0;
+    n += ac.feed("conn time", 9, [](uint64_t, int) {});
+    n += ac.feed("ou", 2, [](uint64_t, int) {});
+    match_list found;
+    n += ac.feed("t!", 2, [&](uint64_t end, int id) { found.push_back(std::make_pair(end, ac.pattern(id))); });
+    EXPECT_EQ(2u, n);
+    match_list want = {{12, "timeout"}, {12, "out"}};
+    std::sort(want.begin(), want.end());
+    std::sort(found.begin(), found.end());
+    EXPECT_EQ(want, found);
+
+    ac.reset();
+    EXPECT_EQ(0u, ac.stream_position());
+    EXPECT_EQ(0u, ac.feed("t", 1, [](uint64_t, int) {}));   // no carry-over
+}
+
+TEST(AhoCorasick, AgreesWithBruteForceForAnyChunking)
+{
+    std::vector<std::string> words = random_words(300, 44);
+    commonlibs::Vertex root;
+    for (const std::string &w : words)
+        root.addWord(w.c_str(), w.size());
+    commonlibs::aho_corasick ac = commonlibs::aho_corasick::compile(root);
+
+    std::string text;
+    unsigned seed = 5;
+    for (int k = 0; k < 20000; ++k) {
+        seed = seed * 1103515245u + 12345u;
+        const unsigned r = (seed >> 16) % 40;
+        text.push_back(r < 30 ? (char)('a' + r % 8) : r < 35 ? (char)('A' + r % 8) : " .\n-9"[r % 5]);
+    }
+    match_list want = brute_force_matches(words, text);
+    EXPECT_FALSE(want.empty());
+    for (std::size_t chunk : {1u, 7u, 4096u, 20000u}) {
+        ac.reset();
+        ASSERT_EQ(want, scan(ac, text, chunk)) << "chunk " << chunk;
+    }
+}
+
+// ---- countWords_batch -------------------------------------------------------
+
+TEST(PrefixTree, CountWordsBatchMatchesCountWords)
+{
+    std::vector<std::string> words = random_words(3000, 61);
+    commonlibs::Vertex root;
+    for (std::size_t k = 0; k < words.size(); k += 2)
+        root.addWord(words[k].c_str(), words[k].size());
+    // every other word is a miss, plus prefixes, extensions and odd input
+    std::vector<std::string> probe(words);
+    for (std::size_t k = 0; k < 500; ++k) {
+        probe.push_back(words[k].substr(0, words[k].size() / 2));
+        probe.push_back(words[k] + "zq");
+    }
+    probe.push_back("");
+    probe.push_back("AbC");
+    probe.push_back("ab1");
+
+    std::ostringstream oss;
+    auto *olderr = std::cerr.rdbuf(oss.rdbuf());
+    std::vector<int> got = root.countWords_batch(probe);
+    std::vector<const char *> p;
+    std::vector<std::size_t> n;
+    for (const std::string &w : probe) {
+        p.push_back(w.c_str());
+        n.push_back(w.size());
+    }
+    std::vector<int> raw(probe.size(), -7);
+    root.countWords_batch(p.data(), n.data(), probe.size(), raw.data());
+    ASSERT_EQ(probe.size(), got.size());
+    for (std::size_t k = 0; k < probe.size(); ++k) {
+        ASSERT_EQ(root.countWords(probe[k].c_str(), probe[k].size()), got[k]) << probe[k];
+        ASSERT_EQ(got[k], raw[k]) << probe[k];
+    }
+    std::cerr.rdbuf(olderr);
+    EXPECT_TRUE(root.countWords_batch(std::vector<std::string>()).empty());
+}
+
+// ---- fuzzy search -----------------------------------------------------------
+
+static int levenshtein(const std::string &a, const std::string &b)
+{
+    std::vector<int> row(b.size() + 1);
+    for (std::size_t j = 0; j <= b.size(); ++j) row[j] = (int)j;
+    for (std::size_t i = 1; i <= a.size(); ++i) {
+        int diag = row[0];
+        row[0] = (int)i;
+        for (std::size_t j = 1; j <= b.size(); ++j) {
+            int up = row[j];
+            row[j] = std::min(std::min(row[j] + 1, row[j - 1] + 1), diag + (a[i - 1] == b[j - 1] ? 0 : 1));
+            diag = up;
+        }
+    }
+    return row[b.size()];
+}
+
+TEST(PrefixTree, FuzzySearchSmallDictionary)
+{
+    commonlibs::Vertex root;
+    for (const char *w : {"hello", "help", "hell", "yellow", "world", "hello"})
+        add(root, w);
+    std::vector<std::string> got;
+    for (const commonlibs::fuzzy_match &m : commonlibs::fuzzy_search(&root, "Helo", 4, 1))
+        got.push_back(m.word);
+    EXPECT_EQ((std::vector<std::string>{"hell", "hello", "help"}), got);
+
+    commonlibs::fuzzy_iterator it(&root, "hello", 5, 0);
+    ASSERT_TRUE(it != commonlibs::fuzzy_iterator());
+    EXPECT_EQ("hello", it->word);
+    EXPECT_EQ(2, it->count);
+    EXPECT_EQ(0, it->distance);
+    EXPECT_TRUE(++it == commonlibs::fuzzy_iterator());
+
+    got.clear();
+    for (const commonlibs::fuzzy_match &m : commonlibs::fuzzy_search(&root, "yelo", 4, 2))
+        got.push_back(m.word + ":" + std::to_string(m.distance));
+    EXPECT_EQ((std::vector<std::string>{"hell:2", "hello:2", "help:2", "yellow:2"}), got);
+}
+
+TEST(PrefixTree, FuzzySearchEdgeCases)
+{
+    commonlibs::Vertex root;
+    add(root, "a");
+    add(root, "ab");
+    std::vector<std::string> got;
+    for (const commonlibs::fuzzy_match &m : commonlibs::fuzzy_search(&root, "", 0, 1))
+        got.push_back(m.word);
+    EXPECT_EQ((std::vector<std::string>{"a"}), got);
+    EXPECT_TRUE(commonlibs::fuzzy_iterator(&root, "zz", 2, -1) == commonlibs::fuzzy_iterator());
+
+    std::ostringstream oss;
+    auto *olderr = std::cerr.rdbuf(oss.rdbuf());
+    EXPECT_TRUE(commonlibs::fuzzy_iterator(&root, "a1", 2, 2) == commonlibs::fuzzy_iterator());
+    std::cerr.rdbuf(olderr);
+}
+
+TEST(PrefixTree, FuzzySearchMatchesBruteForce)
+{
+    std::vector<std::string> words = random_words(4000, 73);
+    commonlibs::Vertex root;
+    std::map<std::string, int> ref;
+    for (const std::string &w : words) {
+        root.addWord(w.c_str(), w.size());
+        ++ref[w];
+    }
+    std::vector<std::string> queries = random_words(60, 4);
+    queries.push_back(words[0]);
+    for (int d = 0; d <= 2; ++d)
+        for (const std::string &q : queries) {
+            std::vector<std::string> want, got;
+            for (const auto &kv : ref) {
+                int dist = levenshtein(q, kv.first);
+                if (dist <= d)
+                    want.push_back(kv.first + ":" + std::to_string(kv.second) + ":" + std::to_string(dist));
+            }
+            for (const commonlibs::fuzzy_match &m : commonlibs::fuzzy_search(&root, q.c_str(), q.size(), d))
+                got.push_back(m.word + ":" + std::to_string(m.count) + ":" + std::to_string(m.distance));
+            ASSERT_EQ(want, got) << q << " d=" << d;
+        }
+}
@@ -1,5 +1,8 @@
 #include "commonlibs/segment_tree.hpp"
 #include <gtest/gtest.h>
+#include <climits>
+#include <sstream>
+#include <vector>
 
 // ---- helpers ---------------------------------------------------------------
 
@@ -214,3 +217,338 @@ TEST(SegmentTree, LargeArray_64Elements)
     EXPECT_LE(idx, 10);
     EXPECT_EQ(100, a[idx]);
 }
+
+// ---- point / run updates ----------------------------------------------------
+
+TEST(SegmentTree, PointUpdateMovesMinimum)
+{
+    int a[] = {5, 3, 1, 4, 9};
+    auto t = make_tree(a, 5);
+    ASSERT_EQ(2, min_index(t, 0, 4));
+
+    EXPECT_EQ(0, t.update(2, 10));      // old minimum becomes the largest
+    EXPECT_EQ(1, min_index(t, 0, 4));   // 3 at index 1
+    EXPECT_EQ(3, min_index(t, 2, 4));   // 4 at index 3
+
+    EXPECT_EQ(0, t.update(4, -2));
+    EXPECT_EQ(4, min_index(t, 0, 4));
+    EXPECT_EQ(-2, t.value(4));
+    EXPECT_EQ(9, a[4]);                 // source array is left untouched
+}
+
+TEST(SegmentTree, PointUpdateOutOfRangeFails)
+{
+    int a[] = {1, 2, 3};
+    auto t = make_tree(a, 3);
+    std::ostringstream oss;
+    auto *olderr = std::cerr.rdbuf(oss.rdbuf());
+    EXPECT_EQ(-1, t.update(3, 0));
+    EXPECT_EQ(-1, t.update(-1, 0));
+    std::cerr.rdbuf(olderr);
+    EXPECT_EQ(0, min_index(t, 0, 2));
+}
+
+TEST(SegmentTree, RunUpdateRewritesConsecutiveElements)
+{
+    int a[] = {7, 6, 5, 4, 3, 2, 1};
+    auto t = make_tree(a, 7);
+    int v[] = {0, 8, 8};
+    EXPECT_EQ(0, t.update(1, v, 3));    // {7, 0, 8, 8, 3, 2, 1}
+    EXPECT_EQ(1, min_index(t, 0, 6));
+    EXPECT_EQ(6, min_index(t, 2, 6));
+    EXPECT_EQ(2, min_index(t, 2, 3));   // tie 8/8: leftmost index
+}
+
+TEST(SegmentTree, RunUpdateOutOfRangeFails)
+{
+    int a[] = {4, 2, 7};
+    auto t = make_tree(a, 3);
+    int v[] = {0, 0};
+    std::ostringstream oss;
+    auto *olderr = std::cerr.rdbuf(oss.rdbuf());
+    EXPECT_EQ(-1, t.update(2, v, 2));
+    EXPECT_EQ(-1, t.update(-1, v, 2));
+    EXPECT_EQ(-1, t.update(0, NULL, 2));
+    std::cerr.rdbuf(olderr);
+    EXPECT_NE(std::string::npos, oss.str().find("Error, update range [2, 4) out of range [0, 3)"));
+    EXPECT_EQ(1, min_index(t, 0, 2));
+}
+
+TEST(SegmentTree, UpdatesMatchBruteForce)
+{
+    // Non-power-of-two size exercises the wrapped leaves of the 2n layout
+    const int n = 37;
+    std::vector<int> a(n);
+    unsigned seed = 12345;
+    auto rnd = [&seed]() { seed = seed * 1103515245u + 12345u; return (int)((seed >> 16) % 100); };
+    for (int k = 0; k < n; ++k) a[k] = rnd();
+
+    auto t = make_tree(a.data(), n);
+    for (int round = 0; round < 200; ++round) {
+        if (round % 3 == 0) {
+            int i = rnd() % n;
+            a[i] = rnd();
+            ASSERT_EQ(0, t.update(i, a[i]));
+        } else if (round % 3 == 1) {
+            int first = rnd() % n;
+            int count = 1 + rnd() % (n - first);
+            for (int k = 0; k < count; ++k) a[first + k] = rnd();
+            ASSERT_EQ(0, t.update(first, a.data() + first, count));
+        }
+        for (int i = 0; i < n; i += 3) {
+            for (int j = i; j < n; j += 5) {
+                int expect = i;
+                for (int k = i; k <= j; ++k)
+                    if (a[k] < a[expect]) expect = k;
+                ASSERT_EQ(expect, min_index(t, i, j)) << "range [" << i << "," << j << "]";
+            }
+        }
+    }
+}
+
+// ---- generic segment_tree<T, Op> --------------------------------------------
+
+using commonlibs::segment_tree;
+
+TEST(GenericSegmentTree, SumMaxMinGcd)
+{
+    long long v[] = {12, 18, 6, 30, 24, 9};
+    segment_tree<long long, commonlibs::sum_op<long long> > sum(v, 6);
+    segment_tree<long long, commonlibs::max_op<long long> > mx(v, 6);
+    segment_tree<long long, commonlibs::min_op<long long> > mn(v, 6);
+    segment_tree<long long, commonlibs::gcd_op<long long> > g(v, 6);
+
+    EXPECT_EQ(99, sum.query(0, 5));
+    EXPECT_EQ(60, sum.query(2, 4));
+    EXPECT_EQ(30, mx.query(0, 5));
+    EXPECT_EQ(18, mx.query(0, 2));
+    EXPECT_EQ(6, mn.query(0, 5));
+    EXPECT_EQ(9, mn.query(4, 5));
+    EXPECT_EQ(6, g.query(0, 4));
+    EXPECT_EQ(3, g.query(0, 5));
+
+    sum.update(5, 1);
+    g.update(5, 36);
+    EXPECT_EQ(91, sum.query(0, 5));
+    EXPECT_EQ(6, g.query(0, 5));
+}
+
+TEST(GenericSegmentTree, EmptyRangeReturnsIdentity)
+{
+    int v[] = {1, 2, 3};
+    segment_tree<int, commonlibs::sum_op<int> > sum(v, 3);
+    EXPECT_EQ(0, sum.query(2, 1));
+    EXPECT_EQ(0, sum.query(5, 9));
+    EXPECT_EQ(6, sum.query(-4, 9));     // clamped to the array
+
+    segment_tree<int, commonlibs::sum_op<int> > none;
+    EXPECT_EQ(0, none.size());
+    EXPECT_EQ(0, none.query(0, 0));
+}
+
+TEST(GenericSegmentTree, ArgmaxLeftmostOnTies)
+{
+    typedef commonlibs::indexed_value<double> iv;
+    iv v[] = {iv(1.5, 0), iv(4.0, 1), iv(2.0, 2), iv(4.0, 3)};
+    segment_tree<iv, commonlibs::argmax_op<double> > t(v, 4);
+    EXPECT_EQ(1, t.query(0, 3).index);
+    EXPECT_EQ(3, t.query(2, 3).index);
+    EXPECT_DOUBLE_EQ(4.0, t.query(0, 3).value);
+}
+
+// Composition of affine maps x -> a*x + b is associative but not
+// commutative, so it checks that the query combines nodes in array order.
+struct affine { long long a, b; };
+struct compose_op {
+    static affine identity() { return affine{1, 0}; }
+    // apply l first, then r
+    affine operator()(const affine &l, const affine &r) const {
+        return affine{r.a * l.a % 1000003, (r.a * l.b + r.b) % 1000003};
+    }
+};
+
+TEST(GenericSegmentTree, NonCommutativeCustomStruct)
+{
+    for (int n = 1; n <= 19; ++n) {
+        std::vector<affine> v(n);
+        for (int k = 0; k < n; ++k) v[k] = affine{k + 2, 3 * k + 1};
+        segment_tree<affine, compose_op> t(v.data(), n);
+        t.update(n / 2, affine{7, 5});
+        v[n / 2] = affine{7, 5};
+
+        for (int i = 0; i < n; ++i) {
+            for (int j = i; j < n; ++j) {
+                affine expect = compose_op::identity();
+                for (int k = i; k <= j; ++k) expect = compose_op()(expect, v[k]);
+                affine got = t.query(i, j);
+                ASSERT_EQ(expect.a, got.a) << "n=" << n << " [" << i << "," << j << "]";
+                ASSERT_EQ(expect.b, got.b) << "n=" << n << " [" << i << "," << j << "]";
+            }
+        }
+    }
+}
+
+// ---- lazy_segments_tree ------------------------------------------------------
+
+TEST(LazySegmentTree, MatchesSegmentsTreeWithoutUpdates)
+{
+    int a[] = {4, 2, 7, 1, 8, 3};
+    commonlibs::lazy_segments_tree t(a, 6);
+    t.initialize(0, 0, 5);
+    EXPECT_EQ(3, t.query(0, 0, 5));
+    EXPECT_EQ(1, t.query(0, 0, 2));
+    EXPECT_EQ(5, t.query(0, 4, 5));
+    EXPECT_EQ(-1, t.query(0, 6, 9));
+}
+
+TEST(LazySegmentTree, RangeAddAndAssign)
+{
+    int a[] = {5, 3, 1, 4, 9};
+    commonlibs::lazy_segments_tree t(a, 5);
+    t.initialize();
+
+    EXPECT_EQ(0, t.add(1, 2, 10));      // {5, 13, 11, 4, 9}
+    EXPECT_EQ(3, t.query(0, 0, 4));
+    EXPECT_EQ(0, t.query(0, 0, 2));
+    EXPECT_EQ(11, t.value(2));
+
+    EXPECT_EQ(0, t.assign(0, 3, 2));    // {2, 2, 2, 2, 9}
+    EXPECT_EQ(0, t.query(0, 0, 4));     // leftmost of the tie
+    EXPECT_EQ(2, t.query(0, 2, 4));
+    EXPECT_EQ(2, t.query_value(1, 4));
+
+    EXPECT_EQ(0, t.add(0, 1, 1));       // {3, 3, 2, 2, 9}
+    EXPECT_EQ(2, t.query(0, 0, 4));
+    EXPECT_EQ(9, t.value(4));
+}
+
+TEST(LazySegmentTree, InvalidRangeFails)
+{
+    int a[] = {1, 2, 3};
+    commonlibs::lazy_segments_tree t(a, 3);
+    t.initialize();
+    std::ostringstream oss;
+    auto *olderr = std::cerr.rdbuf(oss.rdbuf());
+    EXPECT_EQ(-1, t.add(2, 1, 5));
+    EXPECT_EQ(-1, t.assign(0, 3, 5));
+    EXPECT_EQ(-1, t.add(-1, 0, 5));
+    std::cerr.rdbuf(olderr);
+    EXPECT_EQ(0, t.query(0, 0, 2));
+}
+
+TEST(LazySegmentTree, RejectsUpdatesBeforeInitialize)
+{
+    int a[] = {1, 2, 3};
+    commonlibs::lazy_segments_tree t(a, 3);
+    std::ostringstream oss;
+    auto *olderr = std::cerr.rdbuf(oss.rdbuf());
+    EXPECT_EQ(-1, t.add(0, 2, 5));
+    EXPECT_EQ(-1, t.assign(0, 2, 5));
+    std::cerr.rdbuf(olderr);
+    EXPECT_EQ(-1, t.query(0, 0, 2));
+    EXPECT_EQ(INT_MAX, t.query_value(0, 2));
+    EXPECT_EQ(INT_MAX, t.value(1));
+
+    commonlibs::lazy_segments_tree unbuilt(NULL, 3);
+    unbuilt.initialize();
+    olderr = std::cerr.rdbuf(oss.rdbuf());
+    EXPECT_EQ(-1, unbuilt.add(0, 2, 5));
+    std::cerr.rdbuf(olderr);
+
+    t.initialize();
+    EXPECT_EQ(0, t.add(0, 2, 5));
+    EXPECT_EQ(6, t.query_value(0, 2));
+}
+
+TEST(LazySegmentTree, MatchesBruteForce)
+{
+    const int n = 29;
+    std::vector<int> a(n);
+    unsigned seed = 777;
+    auto rnd = [&seed]() { seed = seed * 1103515245u + 12345u; return (int)((seed >> 16) % 50); };
+    for (int k = 0; k < n; ++k) a[k] = rnd();
+
+    commonlibs::lazy_segments_tree t(a.data(), n);
+    t.initialize();
+    for (int round = 0; round < 300; ++round) {
+        int i = rnd() % n, j = rnd() % n;
+        if (i > j) std::swap(i, j);
+        int v = rnd() - 25;
+        if (round % 2 == 0) {
+            ASSERT_EQ(0, t.add(i, j, v));
+            for (int k = i; k <= j; ++k) a[k] += v;
+        } else {
+            ASSERT_EQ(0, t.assign(i, j, v));
+            for (int k = i; k <= j; ++k) a[k] = v;
+        }
+        int qi = rnd() % n, qj = rnd() % n;
+        if (qi > qj) std::swap(qi, qj);
+        int expect = qi;
+        for (int k = qi; k <= qj; ++k)
+            if (a[k] < a[expect]) expect = k;
+        ASSERT_EQ(expect, t.query(0, qi, qj)) << "round " << round;
+        ASSERT_EQ(a[expect], t.query_value(qi, qj));
+    }
+}
+
+// ---- batched queries ---------------------------------------------------------
+
+TEST(SegmentTreeBatch, MatchesSingleQueries)
+{
+    const int n = 1000;
+    std::vector<int> a(n);
+    unsigned seed = 4242;
+    auto rnd = [&seed]() { seed = seed * 1103515245u + 12345u; return (int)(seed >> 8); };
+    for (int k = 0; k < n; ++k) a[k] = rnd() % 500;
+    auto t = make_tree(a.data(), n);
+
+    std::vector<std::pair<int, int> > q;
+    for (int k = 0; k < 20000; ++k) {
+        int i = rnd() % n, j = rnd() % n;
+        q.push_back(std::make_pair(i < j ? i : j, i < j ? j : i));
+    }
+    q.push_back(std::make_pair(5, 4));      // empty
+    q.push_back(std::make_pair(n, n + 3));  // past the end
+    q.push_back(std::make_pair(-7, 3));     // clamped
+
+    std::vector<int> single(q.size());
+    for (std::size_t k = 0; k < q.size(); ++k)
+        single[k] = min_index(t, q[k].first, q[k].second);
+
+    EXPECT_EQ(single, t.query_batch(q));
+    EXPECT_EQ(single, t.query_batch(q, 4));
+
+    std::vector<int> out(q.size(), -2);
+    t.query_batch(q.data(), q.size(), out.data(), 3);
+    EXPECT_EQ(single, out);
+    EXPECT_EQ(-1, out[q.size() - 3]);
+    EXPECT_EQ(-1, out[q.size() - 2]);
+}
+
+TEST(SegmentTreeBatch, BeforeInitializeBothReturnMinusOne)
+{
+    int a[] = {3, 1, 2};
+    commonlibs::segments_tree t(a, 3);
+    std::vector<std::pair<int, int> > q = {{0, 2}, {1, 1}};
+    EXPECT_EQ(-1, t.query(0, 0, 2));
+    EXPECT_EQ(-1, t.query(0, 1, 1));
+    EXPECT_EQ(std::vector<int>(2, -1), t.query_batch(q));
+    t.initialize();
+    EXPECT_EQ(1, t.query(0, 0, 2));
+    EXPECT_EQ(std::vector<int>({1, 1}), t.query_batch(q));
+}
+
+TEST(SegmentTreeBatch, GenericTreeAndEmptyBatch)
+{
+    long long v[] = {3, 1, 4, 1, 5, 9, 2, 6};
+    segment_tree<long long, commonlibs::sum_op<long long> > sum(v, 8);
+    std::vector<std::pair<int, int> > q = {{0, 7}, {2, 4}, {6, 6}, {3, 2}};
+    std::vector<long long> out = sum.query_batch(q);
+    ASSERT_EQ(4u, out.size());
+    EXPECT_EQ(31, out[0]);
+    EXPECT_EQ(10, out[1]);
+    EXPECT_EQ(2, out[2]);
+    EXPECT_EQ(0, out[3]);
+
+    EXPECT_TRUE(sum.query_batch(std::vector<std::pair<int, int> >()).empty());
+}
@@ -0,0 +1,156 @@
+#include "commonlibs/sliding_window.hpp"
+#include "commonlibs/segment_tree.hpp"
+#include <gtest/gtest.h>
+#include <climits>
+#include <string>
+#include <vector>
+
+using commonlibs::sliding_window;
+using commonlibs::monotonic_window;
+
+// string concatenation: associative but not commutative
+struct concat_op {
+    static std::string identity() { return std::string(); }
+    std::string operator()(const std::string &a, const std::string &b) const { return a + b; }
+};
+
+static std::vector<int> random_stream(int n, unsigned seed)
+{
+    std::vector<int> v(n);
+    for (int k = 0; k < n; ++k) {
+        seed = seed * 1103515245u + 12345u;
+        v[k] = (int)((seed >> 16) % 100) - 50;
+    }
+    return v;
+}
+
+TEST(SlidingWindow, EmptyReturnsIdentity)
+{
+    sliding_window<int, commonlibs::sum_op<int> > s(3);
+    EXPECT_TRUE(s.empty());
+    EXPECT_EQ(0, s.query());
+    s.pop();   // no-op
+    EXPECT_EQ(0u, s.size());
+
+    monotonic_window<int, commonlibs::min_op<int> > m(3);
+    EXPECT_TRUE(m.empty());
+    EXPECT_EQ(INT_MAX, m.query());
+    m.pop();
+    EXPECT_EQ(0u, m.size());
+}
+
+TEST(SlidingWindow, SumEvictsOldest)
+{
+    sliding_window<int, commonlibs::sum_op<int> > s(3);
+    s.push(1);
+    s.push(2);
+    EXPECT_EQ(3, s.query());
+    s.push(3);
+    EXPECT_EQ(6, s.query());
+    s.push(4);          // 1 falls out
+    EXPECT_EQ(9, s.query());
+    EXPECT_EQ(3u, s.size());
+    s.pop();            // 2 falls out
+    EXPECT_EQ(7, s.query());
+    s.clear();
+    EXPECT_EQ(0, s.query());
+}
+
+TEST(SlidingWindow, NonCommutativeKeepsOrder)
+{
+    sliding_window<std::string, concat_op> s(3);
+    const char *words[] = {"a", "b", "c", "d", "e"};
+    for (int k = 0; k < 5; ++k)
+        s.push(words[k]);
+    EXPECT_EQ("cde", s.query());
+    s.pop();
+    EXPECT_EQ("de", s.query());
+    s.push("f");
+    EXPECT_EQ("def", s.query());
+}
+
+TEST(SlidingWindow, MinMaxAgreeWithBruteForce)
+{
+    std::vector<int> v = random_stream(500, 7);
+    for (std::size_t w = 1; w <= 33; w += 4) {
+        sliding_window<int, commonlibs::min_op<int> > smin(w);
+        monotonic_window<int, commonlibs::min_op<int> > mmin(w);
+        monotonic_window<int, commonlibs::max_op<int> > mmax(w);
+        for (std::size_t k = 0; k < v.size(); ++k) {
+            smin.push(v[k]);
+            mmin.push(v[k]);
+            mmax.push(v[k]);
+            int lo = INT_MAX, hi = INT_MIN;
+            for (std::size_t t = k + 1 > w ? k + 1 - w : 0; t <= k; ++t) {
+                lo = std::min(lo, v[t]);
+                hi = std::max(hi, v[t]);
+            }
+            ASSERT_EQ(lo, smin.query()) << "w=" << w << " k=" << k;
+            ASSERT_EQ(lo, mmin.query()) << "w=" << w << " k=" << k;
+            ASSERT_EQ(hi, mmax.query()) << "w=" << w << " k=" << k;
+        }
+    }
+}
+
+TEST(SlidingWindow, ArgminKeepsLeftmostOnTies)
+{
+    typedef commonlibs::indexed_value<int> iv;
+    monotonic_window<iv, commonlibs::argmin_op<int> > m(3);
+    sliding_window<iv, commonlibs::argmin_op<int> > s(3);
+    int v[] = {5, 2, 2, 7, 2, 9};
+    int expect[] = {0, 1, 1, 1, 2, 4};
+    for (int k = 0; k < 6; ++k) {
+        m.push(iv(v[k], k));
+        s.push(iv(v[k], k));
+        EXPECT_EQ(expect[k], m.query().index) << "k=" << k;
+        EXPECT_EQ(expect[k], s.query().index) << "k=" << k;
+    }
+}
+
+TEST(SlidingWindow, ExplicitPopShrinksWindow)
+{
+    std::vector<int> v = random_stream(200, 3);
+    monotonic_window<int, commonlibs::max_op<int> > m(16);
+    sliding_window<int, commonlibs::max_op<int> > s(16);
+    std::size_t oldest = 0;
+    for (std::size_t k = 0; k < v.size(); ++k) {
+        m.push(v[k]);
+        s.push(v[k]);
+        if (k + 1 - oldest > 16)
+            oldest = k + 1 - 16;
+        if (k % 5 == 4) {   // drop two extra samples now and then
+            m.pop();
+            s.pop();
+            m.pop();
+            s.pop();
+            oldest = std::min(oldest + 2, k + 1);
+        }
+        int hi = INT_MIN;
+        for (std::size_t t = oldest; t <= k; ++t)
+            hi = std::max(hi, v[t]);
+        ASSERT_EQ(k + 1 - oldest, m.size());
+        ASSERT_EQ(k + 1 - oldest, s.size());
+        ASSERT_EQ(hi, m.query()) << "k=" << k;
+        ASSERT_EQ(hi, s.query()) << "k=" << k;
+    }
+}
+
+TEST(SlidingWindow, PushBatchMatchesSinglePush)
+{
+    std::vector<int> v = random_stream(300, 11);
+    monotonic_window<int, commonlibs::min_op<int> > single(10), batch(10);
+    sliding_window<int, commonlibs::sum_op<int> > ssingle(10), sbatch(10);
+    std::vector<int> out(v.size()), sout(v.size());
+    batch.push_batch(v.data(), 120, out.data());
+    batch.push_batch(v.data() + 120, v.size() - 120, out.data() + 120);
+    sbatch.push_batch(v.data(), v.size(), sout.data());
+    for (std::size_t k = 0; k < v.size(); ++k) {
+        single.push(v[k]);
+        ssingle.push(v[k]);
+        ASSERT_EQ(single.query(), out[k]) << "k=" << k;
+        ASSERT_EQ(ssingle.query(), sout[k]) << "k=" << k;
+    }
+
+    batch.push_batch(v.data(), 5);   // no output buffer
+    EXPECT_EQ(10u, batch.size());
+}
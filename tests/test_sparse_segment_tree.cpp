@@ -0,0 +1,115 @@
+#include "commonlibs/sparse_segment_tree.hpp"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <sstream>
+
+using commonlibs::sparse_segment_tree;
+
+typedef sparse_segment_tree<long long, commonlibs::sum_op<long long> > sum_tree;
+typedef sparse_segment_tree<int, commonlibs::min_op<int> > min_tree;
+typedef sparse_segment_tree<int, commonlibs::max_op<int> > max_tree;
+
+TEST(SparseSegmentTree, EmptyTreeReturnsIdentity)
+{
+    sum_tree t(0, 1000);
+    EXPECT_EQ(0, t.query(0, 1000));
+    EXPECT_EQ(0u, t.size());
+    EXPECT_EQ(0u, t.node_count());
+}
+
+TEST(SparseSegmentTree, TimestampSums)
+{
+    const int64_t base = 1700000000000000000LL;   // nanosecond timestamps
+    sum_tree t(base, base + 1000000000000LL);
+    EXPECT_EQ(0, t.update(base + 5, 10));
+    EXPECT_EQ(0, t.update(base + 999999999999LL, 7));
+    EXPECT_EQ(0, t.merge(base + 5, 3));            // add for sum_op
+    EXPECT_EQ(0, t.merge(base + 123456789, 100));
+
+    EXPECT_EQ(120, t.query(base, base + 1000000000000LL));
+    EXPECT_EQ(13, t.get(base + 5));
+    EXPECT_EQ(113, t.query(base, base + 123456789));
+    EXPECT_EQ(107, t.query(base + 6, base + 1000000000000LL));
+    EXPECT_EQ(0, t.query(base + 6, base + 123456788));
+    EXPECT_EQ(3u, t.size());
+}
+
+TEST(SparseSegmentTree, MinMaxOverFullSignedRange)
+{
+    const int64_t lo = std::numeric_limits<int64_t>::min();
+    const int64_t hi = std::numeric_limits<int64_t>::max();
+    min_tree mn(lo, hi);
+    max_tree mx(lo, hi);
+    int64_t keys[] = {lo, -1, 0, 42, hi};
+    int vals[] = {5, -3, 8, 1, 9};
+    for (int k = 0; k < 5; ++k) {
+        mn.update(keys[k], vals[k]);
+        mx.update(keys[k], vals[k]);
+    }
+    EXPECT_EQ(-3, mn.query(lo, hi));
+    EXPECT_EQ(9, mx.query(lo, hi));
+    EXPECT_EQ(1, mn.query(0, hi));
+    EXPECT_EQ(8, mx.query(0, 100));
+    EXPECT_EQ(5, mn.query(lo, -2));
+    EXPECT_EQ(std::numeric_limits<int>::max(), mn.query(1, 41));
+}
+
+TEST(SparseSegmentTree, OutOfRangeKeyFails)
+{
+    sum_tree t(100, 200);
+    std::ostringstream oss;
+    auto *olderr = std::cerr.rdbuf(oss.rdbuf());
+    EXPECT_EQ(-1, t.update(99, 1));
+    EXPECT_EQ(-1, t.merge(201, 1));
+    std::cerr.rdbuf(olderr);
+    EXPECT_EQ(0u, t.size());
+    EXPECT_EQ(0, t.query(0, 1000));      // query is clamped to [lo, hi]
+}
+
+TEST(SparseSegmentTree, OneKeyCostsOneSmallChunk)
+{
+    sum_tree t(0, std::numeric_limits<int64_t>::max());
+    EXPECT_EQ(0, t.merge(12345, 1));
+    EXPECT_EQ(1u, t.node_count());
+    EXPECT_GT(t.bytes_reserved(), 0u);
+    EXPECT_LE(t.bytes_reserved(), 64u * 1024u);
+}
+
+TEST(SparseSegmentTree, MemoryProportionalToTouchedKeys)
+{
+    sum_tree t(0, std::numeric_limits<int64_t>::max());
+    uint64_t x = 88172645463325252ULL;
+    for (int k = 0; k < 5000; ++k) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        t.merge((int64_t)(x >> 1), 1);
+    }
+    EXPECT_EQ(5000u, t.size());
+    EXPECT_LE(t.node_count(), 2u * 5000u - 1u);
+    // at most one partly used chunk of 1024 nodes, of 64 bytes at most
+    EXPECT_LE(t.bytes_reserved(), (t.node_count() + 1024u) * 64u);
+    EXPECT_EQ(5000, t.query(0, std::numeric_limits<int64_t>::max()));
+}
+
+TEST(SparseSegmentTree, MatchesMapBruteForce)
+{
+    min_tree t(-5000, 5000);
+    std::map<int64_t, int> ref;
+    unsigned seed = 2024;
+    auto rnd = [&seed]() { seed = seed * 1103515245u + 12345u; return (int)(seed >> 8); };
+    for (int round = 0; round < 3000; ++round) {
+        int64_t key = rnd() % 10001 - 5000;
+        int v = rnd() % 1000;
+        t.update(key, v);
+        ref[key] = v;
+
+        int64_t a = rnd() % 10001 - 5000, b = rnd() % 10001 - 5000;
+        if (a > b) std::swap(a, b);
+        int expect = std::numeric_limits<int>::max();
+        for (auto it = ref.lower_bound(a); it != ref.end() && it->first <= b; ++it)
+            expect = std::min(expect, it->second);
+        ASSERT_EQ(expect, t.query(a, b)) << "[" << a << "," << b << "]";
+    }
+    EXPECT_EQ(ref.size(), t.size());
+}
@@ -0,0 +1,85 @@
+#include "commonlibs/sparse_table.hpp"
+#include "commonlibs/segment_tree.hpp"
+#include <gtest/gtest.h>
+#include <climits>
+#include <vector>
+
+static int min_index(const commonlibs::sparse_table_rmq &t, int i, int j)
+{
+    return t.query(0, i, j);
+}
+
+TEST(SparseTable, SingleElement)
+{
+    int a[] = {42};
+    commonlibs::sparse_table_rmq t(a, 1);
+    t.initialize(0, 0, 0);
+    EXPECT_EQ(0, min_index(t, 0, 0));
+}
+
+TEST(SparseTable, SubrangeQueries)
+{
+    int a[] = {4, 2, 7, 1, 8, 3};
+    commonlibs::sparse_table_rmq t(a, 6);
+    t.initialize(0, 0, 5);
+
+    EXPECT_EQ(3, min_index(t, 0, 5));
+    EXPECT_EQ(1, min_index(t, 0, 2));
+    EXPECT_EQ(3, min_index(t, 2, 4));
+    EXPECT_EQ(5, min_index(t, 4, 5));
+    EXPECT_EQ(5, min_index(t, 5, 5));
+}
+
+TEST(SparseTable, TiesReturnLeftmostIndex)
+{
+    int a[] = {3, 1, 3, 1, 1, 3};
+    commonlibs::sparse_table_rmq t(a, 6);
+    t.initialize();
+    EXPECT_EQ(1, min_index(t, 0, 5));
+    EXPECT_EQ(3, min_index(t, 2, 5));
+    EXPECT_EQ(0, min_index(t, 0, 0));
+}
+
+TEST(SparseTable, ExtremeAndNegativeValues)
+{
+    int a[] = {INT_MAX, -3, INT_MIN, 0, INT_MIN, 7};
+    commonlibs::sparse_table_rmq t(a, 6);
+    t.initialize();
+    EXPECT_EQ(2, min_index(t, 0, 5));
+    EXPECT_EQ(1, min_index(t, 0, 1));
+    EXPECT_EQ(4, min_index(t, 3, 5));
+    EXPECT_EQ(0, min_index(t, 0, 0));
+}
+
+TEST(SparseTable, OutOfRangeAndEmpty)
+{
+    int a[] = {1, 2, 3};
+    commonlibs::sparse_table_rmq t(a, 3);
+    t.initialize();
+    EXPECT_EQ(-1, min_index(t, 3, 5));
+    EXPECT_EQ(-1, min_index(t, 2, 1));
+    EXPECT_EQ(0, min_index(t, -5, 10));   // clamped like segments_tree
+
+    commonlibs::sparse_table_rmq empty(a, 0);
+    empty.initialize();
+    EXPECT_EQ(-1, min_index(empty, 0, 0));
+}
+
+TEST(SparseTable, AgreesWithSegmentsTree)
+{
+    for (int n = 1; n <= 70; n += 3) {
+        std::vector<int> a(n);
+        unsigned seed = 99 + n;
+        for (int k = 0; k < n; ++k) {
+            seed = seed * 1103515245u + 12345u;
+            a[k] = (int)((seed >> 16) % 20) - 10;
+        }
+        commonlibs::sparse_table_rmq st(a.data(), n);
+        st.initialize();
+        commonlibs::segments_tree seg(a.data(), n);
+        seg.initialize(0, 0, n - 1);
+        for (int i = 0; i < n; ++i)
+            for (int j = i; j < n; ++j)
+                ASSERT_EQ(seg.query(0, i, j), st.query(0, i, j)) << "n=" << n << " [" << i << "," << j << "]";
+    }
+}
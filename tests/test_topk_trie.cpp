@@ -0,0 +1,103 @@
+#include "commonlibs/topk_trie.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+typedef commonlibs::topk_trie::completion completion;
+
+static std::vector<completion> complete(const commonlibs::topk_trie &t, const std::string &p, std::size_t n)
+{
+    return t.complete(p.c_str(), p.size(), n);
+}
+
+// reference: sort every word under the prefix
+static std::vector<completion> brute_force(const std::map<std::string, long long> &ref, const std::string &p, std::size_t n)
+{
+    std::vector<completion> all;
+    for (auto it = ref.lower_bound(p); it != ref.end() && it->first.compare(0, p.size(), p) == 0; ++it)
+        all.push_back(*it);
+    std::sort(all.begin(), all.end(), [](const completion &a, const completion &b) {
+        return a.second > b.second || (a.second == b.second && a.first < b.first);
+    });
+    if (all.size() > n)
+        all.resize(n);
+    return all;
+}
+
+TEST(TopkTrie, CompletesHeaviestFirst)
+{
+    commonlibs::topk_trie t(3);
+    t.addWord("car", 3, 3);
+    t.addWord("cart", 4, 5);
+    t.addWord("cat", 3, 1);
+    t.addWord("Care", 4, 4);
+    t.addWord("dog", 3, 9);
+
+    std::vector<completion> want = {{"cart", 5}, {"care", 4}, {"car", 3}};
+    EXPECT_EQ(want, complete(t, "ca", 10));   // capped at k = 3
+    want = {{"cart", 5}, {"care", 4}};
+    EXPECT_EQ(want, complete(t, "CAR", 2));
+    want = {{"dog", 9}};
+    EXPECT_EQ(want, t.complete("d", 1));
+    EXPECT_TRUE(complete(t, "cow", 3).empty());
+    EXPECT_EQ(3u, t.complete("", 0).size());
+
+    EXPECT_EQ(4, t.addWord("cat", 3, 3));  // climbs past "car"
+    want = {{"cart", 5}, {"care", 4}, {"cat", 4}};
+    EXPECT_EQ(want, complete(t, "c", 3));
+    EXPECT_EQ(4, t.weight("cat", 3));
+    EXPECT_EQ(0, t.weight("ca", 2));
+    EXPECT_EQ(5u, t.size());
+}
+
+TEST(TopkTrie, RejectsBadInput)
+{
+    commonlibs::topk_trie t(2);
+    std::ostringstream oss;
+    auto *olderr = std::cerr.rdbuf(oss.rdbuf());
+    EXPECT_EQ(-1, t.addWord("abc", 3, -1));
+    EXPECT_EQ(-1, t.addWord("ab1", 3));
+    EXPECT_EQ(-1, t.addWord("", 0));
+    EXPECT_TRUE(complete(t, "a-", 2).empty());
+    std::cerr.rdbuf(olderr);
+    EXPECT_EQ(0u, t.size());
+    EXPECT_TRUE(complete(t, "a", 2).empty());
+    EXPECT_EQ(0, t.addWord("zero", 4, 0));   // weight 0 still makes a word
+    EXPECT_EQ(1u, complete(t, "z", 2).size());
+}
+
+TEST(TopkTrie, MatchesBruteForceUnderRandomIncrements)
+{
+    for (std::size_t k : {1u, 4u, 10u}) {
+        commonlibs::topk_trie t(k);
+        std::map<std::string, long long> ref;
+        std::vector<std::string> prefixes = {""};
+        unsigned seed = 17 + (unsigned)k;
+        for (int step = 0; step < 4000; ++step) {
+            seed = seed * 1103515245u + 12345u;
+            int len = 1 + (int)((seed >> 16) % 5);
+            std::string w;
+            for (int c = 0; c < len; ++c) {
+                seed = seed * 1103515245u + 12345u;
+                w.push_back((char)('a' + (seed >> 16) % 4));
+            }
+            seed = seed * 1103515245u + 12345u;
+            long long inc = (seed >> 16) % 7;
+            ref[w] += inc;
+            ASSERT_EQ(ref[w], t.addWord(w.c_str(), w.size(), inc));
+            if (step % 50 == 0)
+                prefixes.push_back(w.substr(0, (seed >> 8) % (w.size() + 1)));
+            if (step % 200 == 0)
+                for (const std::string &p : prefixes) {
+                    ASSERT_EQ(brute_force(ref, p, k), complete(t, p, k)) << "k=" << k << " prefix=" << p;
+                }
+        }
+        for (const std::string &p : prefixes)
+            for (std::size_t n = 0; n <= k + 1; ++n)
+                ASSERT_EQ(brute_force(ref, p, std::min(n, k)), complete(t, p, n)) << p;
+        EXPECT_EQ(ref.size(), t.size());
+    }
+}
@@ -0,0 +1,129 @@
+#include "commonlibs/wide_segment_tree.hpp"
+#include "commonlibs/segment_tree.hpp"
+#include <gtest/gtest.h>
+#include <climits>
+#include <sstream>
+#include <vector>
+
+using commonlibs::wide_segments_tree;
+
+TEST(WideSegmentTree, SingleElement)
+{
+    int a[] = {42};
+    wide_segments_tree<> t(a, 1);
+    t.initialize(0, 0, 0);
+    EXPECT_EQ(0, t.query(0, 0, 0));
+    EXPECT_EQ(1, t.levels());
+}
+
+TEST(WideSegmentTree, SubrangeQueries)
+{
+    int a[] = {4, 2, 7, 1, 8, 3};
+    wide_segments_tree<4> t(a, 6);
+    t.initialize();
+    EXPECT_EQ(3, t.query(0, 0, 5));
+    EXPECT_EQ(1, t.query(0, 0, 2));
+    EXPECT_EQ(3, t.query(0, 2, 4));
+    EXPECT_EQ(5, t.query(0, 4, 5));
+    EXPECT_EQ(-1, t.query(0, 6, 8));
+    EXPECT_EQ(-1, t.query(0, 3, 2));
+}
+
+TEST(WideSegmentTree, HeightShrinksWithFanout)
+{
+    std::vector<int> a(100000, 1);
+    wide_segments_tree<16> wide(a.data(), (int)a.size());
+    wide.initialize();
+    EXPECT_EQ(5, wide.levels());    // 100000 -> 6250 -> 391 -> 25 -> 2 -> 1
+    wide_segments_tree<4> narrow(a.data(), (int)a.size());
+    narrow.initialize();
+    EXPECT_EQ(9, narrow.levels());
+}
+
+TEST(WideSegmentTree, TiesAndIntMaxValues)
+{
+    int a[] = {INT_MAX, INT_MAX, 5, INT_MAX, 5, INT_MAX};
+    wide_segments_tree<4> t(a, 6);
+    t.initialize();
+    EXPECT_EQ(2, t.query(0, 0, 5));
+    EXPECT_EQ(4, t.query(0, 3, 5));
+    EXPECT_EQ(0, t.query(0, 0, 1));
+    EXPECT_EQ(5, t.query(0, 5, 5));
+}
+
+TEST(WideSegmentTree, UpdateAndOutOfRange)
+{
+    int a[] = {5, 3, 1, 4, 9};
+    wide_segments_tree<4> t(a, 5);
+    t.initialize();
+    EXPECT_EQ(0, t.update(2, 10));
+    EXPECT_EQ(1, t.query(0, 0, 4));
+    EXPECT_EQ(10, t.value(2));
+    EXPECT_EQ(1, a[2]);
+
+    std::ostringstream oss;
+    auto *olderr = std::cerr.rdbuf(oss.rdbuf());
+    EXPECT_EQ(-1, t.update(5, 0));
+    std::cerr.rdbuf(olderr);
+}
+
+template <int B>
+static void check_against_segments_tree(int n, unsigned seed)
+{
+    std::vector<int> a(n);
+    auto rnd = [&seed]() { seed = seed * 1103515245u + 12345u; return (int)((seed >> 16) % 1000) - 500; };
+    for (int k = 0; k < n; ++k) a[k] = rnd() % 30;
+
+    wide_segments_tree<B> wide(a.data(), n);
+    wide.initialize();
+    commonlibs::segments_tree seg(a.data(), n);
+    seg.initialize(0, 0, n - 1);
+    for (int round = 0; round < 2000; ++round) {
+        if (round % 10 == 0) {
+            int i = (rnd() + 500) % n, v = rnd() % 30;
+            ASSERT_EQ(0, wide.update(i, v));
+            seg.update(i, v);
+        }
+        int i = (rnd() + 500) % n, j = (rnd() + 500) % n;
+        if (i > j) std::swap(i, j);
+        ASSERT_EQ(seg.query(0, i, j), wide.query(0, i, j)) << "B=" << B << " n=" << n << " [" << i << "," << j << "]";
+    }
+}
+
+TEST(WideSegmentTree, AgreesWithSegmentsTree)
+{
+    check_against_segments_tree<4>(1, 1);
+    check_against_segments_tree<4>(97, 2);
+    check_against_segments_tree<8>(513, 3);
+    check_against_segments_tree<16>(16, 4);
+    check_against_segments_tree<16>(4099, 5);
+    check_against_segments_tree<16>(70000, 6);
+}
+
+// block_min is the vector scan when the target has SSE4.2 (the
+// test_wide_segment_tree_sse42 build) and the scalar one otherwise
+template <int B>
+static void check_block_min(unsigned seed)
+{
+    typedef commonlibs::wide_block_ops<B> ops;
+    alignas(64) long long p[B];
+    for (int round = 0; round < 200; ++round) {
+        for (int k = 0; k < B; ++k) {
+            seed = seed * 1103515245u + 12345u;
+            int v = round % 3 == 0 ? (int)(seed >> 16) % 4 : (int)seed;
+            if (round % 7 == 0 && k % 3 == 0) v = k % 2 ? INT_MIN : INT_MAX;
+            p[k] = round % 11 == 0 && k == B - 1 ? ops::empty_key() : ops::make_key(v, seed % 1000);
+        }
+        for (unsigned lo = 0; lo < (unsigned)B; ++lo)
+            for (unsigned hi = lo; hi < (unsigned)B; ++hi)
+                ASSERT_EQ(ops::block_min_scalar(p, lo, hi), ops::block_min(p, lo, hi)) << lo << ".." << hi;
+    }
+}
+
+TEST(WideBlockOps, BlockMinMatchesScalarScan)
+{
+    check_block_min<2>(1);
+    check_block_min<4>(2);
+    check_block_min<8>(3);
+    check_block_min<16>(4);
+}